@@ -0,0 +1,94 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * bench.c - Shared helpers for the simulator microbenchmarks.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include "bench.h"
+#include "instructions.h"
+
+double bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+void bench_init_guest(void) {
+    infile = stdin;
+    outfile = stdout;
+    errfile = stderr;
+    init_machine("AArch64", 64, L_ENDIAN, L_ENDIAN);
+    init_itable();
+    guest.proc->regs[R_SP].xval = guest.mem->seg_start_addr[KERNEL_SEG]-8;
+}
+
+void bench_load_code(const uint64_t addr, const uint32_t *words, const unsigned n) {
+    for (unsigned i = 0; i < n; i++)
+        mem_write_I(addr + 4*i, words[i]);
+}
+
+/*
+ * Run one instruction through all stages, as runElf does. If eager_cc is
+ * set, NZCV is materialized right after every flag-setting instruction,
+ * which is what eager flag evaluation costs.
+ */
+
+void bench_step(const bool eager_cc) {
+    instr_t insn;
+    memset(&insn, 0, sizeof(insn));
+    fetch_instr(&insn);
+    decode_instr(&insn);
+    execute_instr(&insn);
+    memory_instr(&insn);
+    wback_instr(&insn);
+    if (eager_cc) read_nzcv();
+    update_pc_instr(&insn);
+}
+
+static int cmp_double(const void *a, const void *b) {
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+bench_stats_t bench_summarize(double *samples, const unsigned n) {
+    bench_stats_t s = {0, 0, 0, 0};
+    for (unsigned i = 0; i < n; i++) s.mean += samples[i];
+    s.mean /= n;
+    for (unsigned i = 0; i < n; i++) s.stddev += (samples[i] - s.mean) * (samples[i] - s.mean);
+    s.stddev = n > 1 ? sqrt(s.stddev / (n - 1)) : 0.0;
+    qsort(samples, n, sizeof(double), cmp_double);
+    s.min = samples[0];
+    s.median = samples[n / 2];
+    return s;
+}
+
+/*
+ * Time fn, which performs n operations per call, once to warm up and then
+ * BENCH_REPS times, and report ns per operation under name.
+ */
+
+bench_stats_t bench_measure(const char *name, void (*fn)(const unsigned), const unsigned n) {
+    double samples[BENCH_REPS];
+    fn(n);
+    for (int r = 0; r < BENCH_REPS; r++) {
+        double t0 = bench_now_ns();
+        fn(n);
+        samples[r] = (bench_now_ns() - t0) / n;
+    }
+    bench_stats_t s = bench_summarize(samples, BENCH_REPS);
+    bench_report(name, &s);
+    return s;
+}
+
+void bench_report(const char *name, const bench_stats_t *s) {
+    printf("%-32s %10.2f ns/op  +- %6.2f  (min %.2f, median %.2f)\n",
+           name, s->mean, s->stddev, s->min, s->median);
+}
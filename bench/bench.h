@@ -0,0 +1,39 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * bench.h - Shared helpers for the simulator microbenchmarks.
+ *
+ * Each microbenchmark links the simulator modules directly (everything in
+ * src/ except archsim.c) and drives them without going through runElf.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "archsim.h"
+
+#define BENCH_REPS 11
+
+extern __thread machine_t guest;
+
+// Summary of repeated measurements, in ns per operation.
+typedef struct bench_stats {
+    double      mean;
+    double      stddev;
+    double      min;
+    double      median;
+} bench_stats_t;
+
+extern double bench_now_ns(void);
+extern void bench_init_guest(void);
+extern void bench_load_code(const uint64_t addr, const uint32_t *words, const unsigned n);
+extern void bench_step(const bool eager_cc);
+extern bench_stats_t bench_summarize(double *samples, const unsigned n);
+extern bench_stats_t bench_measure(const char *name, void (*fn)(const unsigned), const unsigned n);
+extern void bench_report(const char *name, const bench_stats_t *s);
+#endif
@@ -0,0 +1,93 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * cc_bench.c - Microbenchmark for lazy NZCV evaluation.
+ *
+ * Runs two guest loops through the instruction stages, once with lazy
+ * flags and once forcing NZCV to be materialized after every
+ * flag-setting instruction (the eager scheme), and reports ns per guest
+ * instruction for each.
+ *
+ *   gcd:  subtraction-based GCD, as in testcases/gcd.c; every SUBS
+ *         feeds a B.cond.
+ *   dead: three flag-setting instructions whose flags are never read,
+ *         then a compare-and-branch.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+
+#define CODE_ADDR 0x400000ULL
+#define NUM_INSTRS 2000000
+
+static const uint32_t gcd_code[] = {
+    0xEB01001F, // loop: cmp  x0, x1
+    0x540000C0, //       b.eq done
+    0x54000063, //       b.cc less
+    0xEB010000, //       subs x0, x0, x1
+    0x54FFFF8E, //       b.al loop
+    0xEB000021, // less: subs x1, x1, x0
+    0x54FFFF4E, //       b.al loop
+                // done:
+};
+
+static const uint32_t dead_code[] = {
+    0xAB030042, // loop: adds x2, x2, x3
+    0xEB030084, //       subs x4, x4, x3
+    0xEA0600A5, //       ands x5, x5, x6
+    0xEB0300E7, //       subs x7, x7, x3
+    0x54FFFF81, //       b.ne loop
+                // done:
+};
+
+typedef struct loop {
+    const char *name;
+    const uint32_t *code;
+    unsigned len;
+    uint64_t init[8];   // X0-X7 on (re)entry.
+} loop_t;
+
+static const loop_t loops[] = {
+    {"gcd", gcd_code, sizeof(gcd_code) / 4, {100003, 7}},
+    {"dead", dead_code, sizeof(dead_code) / 4, {0, 0, 0, 1, 0, 0xFF, 0, 100000}},
+};
+
+static void enter_loop(const loop_t *l) {
+    for (int i = 0; i < 8; i++) guest.proc->regs[i].xval = l->init[i];
+    guest.proc->regs[R_PC].xval = CODE_ADDR;
+}
+
+static double run_loop(const loop_t *l, const bool eager) {
+    uint64_t done = CODE_ADDR + 4 * l->len;
+    enter_loop(l);
+    double t0 = bench_now_ns();
+    for (unsigned i = 0; i < NUM_INSTRS; i++) {
+        bench_step(eager);
+        if (done == guest.proc->regs[R_PC].xval) enter_loop(l);
+    }
+    return (bench_now_ns() - t0) / NUM_INSTRS;
+}
+
+int main(int argc, char *argv[]) {
+    char name[64];
+    double samples[BENCH_REPS];
+    bench_init_guest();
+    for (unsigned i = 0; i < sizeof(loops) / sizeof(loops[0]); i++) {
+        const loop_t *l = loops + i;
+        bench_load_code(CODE_ADDR, l->code, l->len);
+        bench_stats_t s[2];
+        for (int eager = 0; eager <= 1; eager++) {
+            run_loop(l, eager); // Warm up.
+            for (int r = 0; r < BENCH_REPS; r++) samples[r] = run_loop(l, eager);
+            s[eager] = bench_summarize(samples, BENCH_REPS);
+            snprintf(name, sizeof(name), "cc/%s/%s", l->name, eager ? "eager" : "lazy");
+            bench_report(name, s + eager);
+        }
+        printf("%-32s %10.3fx\n", "  lazy speedup (median)", s[1].median / s[0].median);
+    }
+    return EXIT_SUCCESS;
+}
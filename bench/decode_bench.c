@@ -0,0 +1,90 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * decode_bench.c - Microbenchmark for instruction decode.
+ *
+ * Reports ns per instruction for decode_instr over a corpus of encodings
+ * (one of each implemented form, in random order), and ns per field for
+ * the bit-field helpers it is built from, safe_GETBF and EXTRACT.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "bench.h"
+
+#define CORPUS_SIZE 4096       // A power of two.
+#define NUM_DECODES 500000
+#define NUM_FIELDS 2000000
+
+static const uint32_t encodings[] = {
+    0xF8408041, // ldur  x1, [x2, #8]
+    0xF81F03E3, // stur  x3, [sp, #-16]
+    0x384010A4, // ldurb w4, [x5, #1]
+    0x380000E6, // sturb w6, [x7]
+    0xD2A24688, // movz  x8, #0x1234, lsl #16
+    0xF297DDE8, // movk  x8, #0xbeef
+    0x91006149, // add   x9, x10, #24
+    0xAB0D018B, // adds  x11, x12, x13
+    0xEB1001EE, // subs  x14, x15, x16
+    0xEB12023F, // cmp   x17, x18
+    0xAA3403F3, // mvn   x19, x20
+    0xAA1702D5, // orr   x21, x22, x23
+    0xCA1A0338, // eor   x24, x25, x26
+    0xEA1D039B, // ands  x27, x28, x29
+    0xD37DF020, // lsl   x0, x1, #3
+    0xD347FC62, // lsr   x2, x3, #7
+    0x937FFCA4, // asr   x4, x5, #63
+    0x14000010, // b     .+64
+    0x54FFFF01, // b.ne  .-32
+    0x94000020, // bl    .+128
+    0xD65F03C0, // ret
+    0xD503201F, // nop
+};
+
+static uint32_t corpus[CORPUS_SIZE];
+static volatile uint64_t sink;
+
+static void decode(const unsigned n) {
+    instr_t insn;
+    uint64_t s = 0;
+    for (unsigned i = 0; i < n; i++) {
+        memset(&insn, 0, sizeof(insn));
+        insn.insnbits = corpus[i & (CORPUS_SIZE - 1)];
+        decode_instr(&insn);
+        s += insn.op;
+    }
+    sink = s;
+}
+
+// The Rn field, at the position and width decode uses.
+static void getbf(const unsigned n) {
+    uint64_t s = 0;
+    for (unsigned i = 0; i < n; i++)
+        s += GETBF(corpus[i & (CORPUS_SIZE - 1)], 5, 5);
+    sink = s;
+}
+
+static void extract(const unsigned n) {
+    uint64_t s = 0;
+    for (unsigned i = 0; i < n; i++)
+        s += EXTRACT(corpus[i & (CORPUS_SIZE - 1)], 0x3E0U, 5);
+    sink = s;
+}
+
+int main(int argc, char *argv[]) {
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    const unsigned num_encodings = sizeof(encodings) / sizeof(encodings[0]);
+    bench_init_guest();
+    for (unsigned i = 0; i < CORPUS_SIZE; i++) {
+        x ^= x << 13; x ^= x >> 7; x ^= x << 17;
+        corpus[i] = encodings[x % num_encodings];
+    }
+    bench_measure("decode/decode_instr", decode, NUM_DECODES);
+    bench_measure("decode/safe_GETBF", getbf, NUM_FIELDS);
+    bench_measure("decode/EXTRACT", extract, NUM_FIELDS);
+    return EXIT_SUCCESS;
+}
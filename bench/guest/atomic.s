@@ -0,0 +1,49 @@
+// atomic.s - Shared counter for multicore runs (see smp.h). Each of the X1
+// cores adds 1 to a 64-bit counter ITERS times with LDXR/STXR, then counts
+// itself done in a 32-bit counter the same way. Core 0 waits until every
+// core is done and prints the number of cores and the counter, which must
+// be X1 * ITERS however the cores interleave. Not a benchmark: the
+// expected output under -c 4 is atomic.out, and "make check" in bench/
+// compares against it.
+	.arch armv8-a
+	.text
+	.align	2
+	.global	start
+start:
+	mvn	x28, xzr			// IO_CHAR_ADDR
+	movz	x20, #0x1000, lsl #16		// counter, in the heap segment
+	add	x21, x20, #64			// done count, on a line of its own
+	movz	x7, #1
+	movz	x6, #0x2710			// ITERS = 10000
+inc:
+	ldxr	x2, [x20]
+	add	x2, x2, #1
+	stxr	w3, x2, [x20]
+	cmp	w3, wzr
+	b.ne	inc				// lost the line: try again
+	subs	x6, x6, x7
+	b.ne	inc
+
+	dmb	ish				// the increments before the done count
+done:
+	ldxr	w2, [x21]
+	add	w2, w2, #1
+	stxr	w3, w2, [x21]
+	cmp	w3, wzr
+	b.ne	done
+
+	cmp	x0, xzr
+	b.ne	out				// only core 0 reports
+wait:
+	ldur	w2, [x21]
+	cmp	x2, x1
+	b.ne	wait
+	dmb	ish				// the done count before the counter
+	isb
+	ldur	x2, [x20]
+	stur	x1, [x28]
+	stur	x2, [x28]
+	dsb	sy
+out:
+	ret
+	.size	start, .-start
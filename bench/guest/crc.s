@@ -0,0 +1,61 @@
+// crc.s - Bitwise CRC-32 (reflected, polynomial 0xEDB88320) over a 64 KiB
+// pseudo-random buffer, repeated PASSES times. Prints the final CRC.
+	.arch armv8-a
+	.text
+	.align	2
+	.global	start
+start:
+	mvn	x28, xzr			// IO_CHAR_ADDR
+	movz	x7, #1
+	movz	x20, #0x1000, lsl #16		// buffer, in the heap segment
+	movz	x21, #0x1, lsl #16		// 65536 bytes
+	adds	x3, x20, x21			// end of buffer
+
+	// Fill the buffer with xorshift64 bytes.
+	movz	x1, #0x2545
+	movk	x1, #0xf491, lsl #16
+	movk	x1, #0x4f6c, lsl #32
+	movk	x1, #0xdd1d, lsl #48
+	mov	x2, x20
+fill:
+	lsl	x4, x1, #13
+	eor	x1, x1, x4
+	lsr	x4, x1, #7
+	eor	x1, x1, x4
+	lsl	x4, x1, #17
+	eor	x1, x1, x4
+	sturb	w1, [x2]
+	add	x2, x2, #1
+	cmp	x2, x3
+	b.ne	fill
+
+	movz	x5, #0x8320
+	movk	x5, #0xedb8, lsl #16		// polynomial
+	mvn	x9, xzr
+	lsr	x9, x9, #32			// 0xFFFFFFFF
+	mov	x8, x9				// crc
+	movz	x6, #8				// PASSES
+pass:
+	mov	x2, x20
+byte:
+	ldurb	w4, [x2]
+	eor	x8, x8, x4
+	movz	x10, #8
+bit:
+	ands	x11, x8, x7
+	lsr	x8, x8, #1
+	b.eq	nopoly
+	eor	x8, x8, x5
+nopoly:
+	subs	x10, x10, x7
+	b.ne	bit
+	add	x2, x2, #1
+	cmp	x2, x3
+	b.ne	byte
+	subs	x6, x6, x7
+	b.ne	pass
+
+	eor	x8, x8, x9
+	stur	x8, [x28]
+	ret
+	.size	start, .-start
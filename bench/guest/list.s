@@ -0,0 +1,49 @@
+// list.s - Linked-list traversal. Builds a list of 32768 16-byte nodes
+// (next, value) scattered over a 512 KiB region by an odd stride, so that
+// consecutive nodes are far apart, then walks it PASSES times summing the
+// values. Prints the sum.
+	.arch armv8-a
+	.text
+	.align	2
+	.global	start
+start:
+	mvn	x28, xzr			// IO_CHAR_ADDR
+	movz	x7, #1
+	movz	x20, #0x1000, lsl #16		// nodes, in the heap segment
+	movz	x21, #0x8000			// n = 32768
+	subs	x9, x21, x7			// index mask
+	movz	x10, #0x1235			// stride, odd
+
+	// Node k lives at base + 16 * p(k), with p(k) = k * stride mod n.
+	mov	x1, xzr				// k
+	mov	x2, xzr				// p(k)
+build:
+	lsl	x3, x2, #4
+	adds	x3, x20, x3			// &node[p(k)]
+	adds	x2, x2, x10
+	ands	x2, x2, x9			// p(k + 1)
+	lsl	x4, x2, #4
+	adds	x4, x20, x4			// &node[p(k + 1)]
+	stur	x4, [x3]
+	stur	x1, [x3, #8]
+	adds	x1, x1, x7
+	cmp	x1, x21
+	b.ne	build
+	stur	xzr, [x3]			// the last node ends the list
+
+	mov	x8, xzr				// sum
+	movz	x6, #128			// PASSES
+pass:
+	mov	x3, x20				// node[p(0)] = node[0]
+walk:
+	ldur	x5, [x3, #8]
+	adds	x8, x8, x5
+	ldur	x3, [x3]
+	cmp	x3, xzr
+	b.ne	walk
+	subs	x6, x6, x7
+	b.ne	pass
+
+	stur	x8, [x28]
+	ret
+	.size	start, .-start
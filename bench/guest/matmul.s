@@ -0,0 +1,94 @@
+// matmul.s - 64x64 integer matrix multiply C = A * B. chArm has no
+// multiply instruction, so products come from a shift-and-add leaf
+// routine. Prints the sum of the elements of C.
+	.arch armv8-a
+	.text
+	.align	2
+	.global	start
+start:
+	mov	x29, x30			// no stack frame: keep the return address
+	mvn	x28, xzr			// IO_CHAR_ADDR
+	movz	x7, #1
+	movz	x20, #0x1000, lsl #16		// A
+	movz	x21, #0x1002, lsl #16		// B
+	movz	x22, #0x1004, lsl #16		// C
+	movz	x15, #0x8000			// 64 * 64 * 8 bytes per matrix
+	movz	x16, #0xff
+	movz	x14, #512			// one row, in bytes
+
+	// Fill A and B with xorshift64 values in 0..255.
+	movz	x1, #0x2545
+	movk	x1, #0xf491, lsl #16
+	movk	x1, #0x4f6c, lsl #32
+	movk	x1, #0xdd1d, lsl #48
+	mov	x2, xzr
+fill:
+	lsl	x4, x1, #13
+	eor	x1, x1, x4
+	lsr	x4, x1, #7
+	eor	x1, x1, x4
+	lsl	x4, x1, #17
+	eor	x1, x1, x4
+	ands	x4, x1, x16
+	adds	x3, x20, x2
+	stur	x4, [x3]
+	lsr	x4, x1, #8
+	ands	x4, x4, x16
+	adds	x3, x21, x2
+	stur	x4, [x3]
+	add	x2, x2, #8
+	cmp	x2, x15
+	b.ne	fill
+
+	mov	x8, xzr				// checksum
+	mov	x10, xzr			// i * 512
+iloop:
+	mov	x11, xzr			// j * 8
+jloop:
+	mov	x9, xzr				// C[i][j]
+	mov	x12, xzr			// k * 8
+	movz	x13, #0				// k * 512
+kloop:
+	adds	x3, x20, x10
+	adds	x3, x3, x12
+	ldur	x0, [x3]			// A[i][k]
+	adds	x3, x21, x13
+	adds	x3, x3, x11
+	ldur	x1, [x3]			// B[k][j]
+	bl	mul
+	adds	x9, x9, x2
+	add	x12, x12, #8
+	add	x13, x13, #512
+	cmp	x12, x14
+	b.ne	kloop
+	adds	x3, x22, x10
+	adds	x3, x3, x11
+	stur	x9, [x3]
+	adds	x8, x8, x9
+	add	x11, x11, #8
+	cmp	x11, x14
+	b.ne	jloop
+	add	x10, x10, #512
+	cmp	x10, x15
+	b.ne	iloop
+
+	stur	x8, [x28]
+	mov	x30, x29
+	ret
+	.size	start, .-start
+
+// x2 = x0 * x1. Clobbers x0, x1, x3.
+	.align	2
+mul:
+	mov	x2, xzr
+mloop:
+	ands	x3, x1, x7
+	b.eq	mskip
+	adds	x2, x2, x0
+mskip:
+	lsl	x0, x0, #1
+	lsr	x1, x1, #1
+	cmp	x1, xzr
+	b.ne	mloop
+	ret
+	.size	mul, .-mul
@@ -0,0 +1,36 @@
+// psum.s - Partial sums for multicore scaling (see smp.h). Each of the X1
+// cores fills a 64 KiB slice of its own, at heap + X0 * 64 KiB, and sums it
+// back, REPS times over, so the cores share no data and every core does the
+// same work whatever X1 is. Run on one core, without -c, it is core 0. It
+// prints nothing; "make scaling" in bench/ times it on 1, 2 and 4 cores.
+	.arch armv8-a
+	.text
+	.align	2
+	.global	start
+start:
+	movz	x20, #0x1000, lsl #16		// in the heap segment
+	lsl	x9, x0, #16
+	adds	x20, x20, x9			// this core's slice
+	movz	x7, #1
+	movz	x3, #0				// the sum
+	movz	x6, #64				// REPS
+rep:
+	movz	x5, #0x2000			// 8192 doublewords
+	mov	x10, x20
+fill:
+	stur	x5, [x10]
+	add	x10, x10, #8
+	subs	x5, x5, x7
+	b.ne	fill
+	movz	x5, #0x2000
+	mov	x10, x20
+sum:
+	ldur	x2, [x10]
+	adds	x3, x3, x2
+	add	x10, x10, #8
+	subs	x5, x5, x7
+	b.ne	sum
+	subs	x6, x6, x7
+	b.ne	rep
+	ret
+	.size	start, .-start
@@ -0,0 +1,86 @@
+// sort.s - Shell sort (gaps n/2, n/4, ..., 1) of 16384 pseudo-random
+// 64-bit integers, followed by a pass that counts out-of-order pairs.
+// Prints the number of out-of-order pairs (0) and the median element.
+	.arch armv8-a
+	.text
+	.align	2
+	.global	start
+start:
+	mvn	x28, xzr			// IO_CHAR_ADDR
+	movz	x7, #1
+	movz	x20, #0x1000, lsl #16		// array, in the heap segment
+	movz	x21, #0x4000			// n = 16384
+	lsl	x15, x21, #3			// n * 8
+	adds	x3, x20, x15			// end of array
+
+	// Fill the array with xorshift64 values.
+	movz	x1, #0x2545
+	movk	x1, #0xf491, lsl #16
+	movk	x1, #0x4f6c, lsl #32
+	movk	x1, #0xdd1d, lsl #48
+	mov	x2, x20
+fill:
+	lsl	x4, x1, #13
+	eor	x1, x1, x4
+	lsr	x4, x1, #7
+	eor	x1, x1, x4
+	lsl	x4, x1, #17
+	eor	x1, x1, x4
+	stur	x1, [x2]
+	add	x2, x2, #8
+	cmp	x2, x3
+	b.ne	fill
+
+	lsr	x12, x21, #1			// gap
+gap:
+	lsl	x13, x12, #3			// gap * 8
+	mov	x14, x13			// i * 8
+outer:
+	adds	x16, x20, x14
+	ldur	x17, [x16]			// tmp = a[i]
+	mov	x18, x14			// j * 8
+inner:
+	cmp	x18, x13
+	b.lo	place
+	subs	x19, x18, x13
+	adds	x22, x20, x19
+	ldur	x23, [x22]			// a[j - gap]
+	cmp	x23, x17
+	b.le	place
+	adds	x24, x20, x18
+	stur	x23, [x24]			// a[j] = a[j - gap]
+	mov	x18, x19
+	b	inner
+place:
+	adds	x24, x20, x18
+	stur	x17, [x24]
+	add	x14, x14, #8
+	cmp	x14, x15
+	b.ne	outer
+	lsr	x12, x12, #1
+	cmp	x12, xzr
+	b.ne	gap
+
+	// Count adjacent pairs that are out of order.
+	mov	x25, xzr
+	mov	x2, x20
+	ldur	x4, [x2]
+check:
+	add	x2, x2, #8
+	cmp	x2, x3
+	b.eq	done
+	ldur	x5, [x2]
+	cmp	x4, x5
+	b.le	inorder
+	adds	x25, x25, x7
+inorder:
+	mov	x4, x5
+	b	check
+done:
+	stur	x25, [x28]
+	lsr	x15, x15, #1
+	adds	x2, x20, x15
+	ldur	x4, [x2]
+	stur	x4, [x28]
+	ret
+	.size	start, .-start
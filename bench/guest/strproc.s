@@ -0,0 +1,96 @@
+// strproc.s - String processing over a 64 KiB NUL-terminated text of
+// lowercase words. Each pass takes the length of the text, then copies it
+// in upper case while counting words and computing a djb2 hash of the
+// copy. Prints the word count summed over all passes, the length plus
+// one, and the hash.
+	.arch armv8-a
+	.text
+	.align	2
+	.global	start
+start:
+	mvn	x28, xzr			// IO_CHAR_ADDR
+	movz	x7, #1
+	movz	x20, #0x1000, lsl #16		// text, in the heap segment
+	movz	x21, #0x1, lsl #16		// 65536 bytes
+	movz	x22, #0x1002, lsl #16		// upper-case copy
+	adds	x3, x20, x21			// end of text
+	movz	x16, #0x7
+	movz	x17, #0xf
+	movz	x18, #0x61			// 'a'
+	movz	x19, #0x20			// ' ', and the case bit
+
+	// About one byte in eight is a space; the rest are letters a..p.
+	movz	x1, #0x2545
+	movk	x1, #0xf491, lsl #16
+	movk	x1, #0x4f6c, lsl #32
+	movk	x1, #0xdd1d, lsl #48
+	mov	x2, x20
+fill:
+	lsl	x4, x1, #13
+	eor	x1, x1, x4
+	lsr	x4, x1, #7
+	eor	x1, x1, x4
+	lsl	x4, x1, #17
+	eor	x1, x1, x4
+	lsr	x4, x1, #4
+	ands	x4, x4, x16
+	b.ne	letter
+	sturb	w19, [x2]
+	b	next
+letter:
+	ands	x4, x1, x17
+	adds	x4, x4, x18
+	sturb	w4, [x2]
+next:
+	add	x2, x2, #1
+	cmp	x2, x3
+	b.ne	fill
+	subs	x2, x3, x7
+	sturb	wzr, [x2]			// NUL terminator
+
+	mov	x8, xzr				// words
+	movz	x9, #5381			// hash
+	movz	x6, #16				// PASSES
+pass:
+	mov	x2, x20
+len:
+	ldurb	w4, [x2]
+	add	x2, x2, #1
+	cmp	x4, xzr
+	b.ne	len
+	subs	x10, x2, x20			// length + 1
+
+	mov	x2, x20
+	mov	x11, x22
+	mov	x12, xzr			// inside a word
+scan:
+	ldurb	w4, [x2]
+	cmp	x4, xzr
+	b.eq	scanned
+	cmp	x4, x19
+	b.eq	space
+	eor	x4, x4, x19			// to upper case
+	cmp	x12, xzr
+	b.ne	store
+	adds	x8, x8, x7
+	mov	x12, x7
+	b	store
+space:
+	mov	x12, xzr
+store:
+	sturb	w4, [x11]
+	lsl	x5, x9, #5
+	adds	x9, x9, x5
+	adds	x9, x9, x4			// hash = hash * 33 + c
+	add	x2, x2, #1
+	add	x11, x11, #1
+	b	scan
+scanned:
+	subs	x6, x6, x7
+	b.ne	pass
+
+	stur	x8, [x28]
+	stur	x10, [x28]
+	stur	x9, [x28]
+	ret
+	.size	start, .-start
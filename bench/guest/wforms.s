@@ -0,0 +1,102 @@
+// wforms.s - The 32-bit (W) forms, and the non-flag-setting ADD, SUB and
+// AND. Each case prints its result as a 64-bit value, so that a stale or
+// sign-extended upper half shows, and the flag-setting ones print NZCV
+// (N = 8, Z = 4, C = 2, V = 1) after it. Not a benchmark: the expected
+// output is wforms.out, and "make check" in bench/ compares against it.
+	.arch armv8-a
+	.text
+	.align	2
+	.global	start
+start:
+	mov	x29, x30			// no stack frame: keep the return address
+	mvn	x28, xzr			// IO_CHAR_ADDR
+
+	// MOVZ/MOVK W clear the upper half.
+	mvn	x1, xzr
+	movz	w1, #0xffff, lsl #16
+	movk	w1, #0xfffe			// 0xfffffffe
+	stur	x1, [x28]
+	movz	w2, #2
+	movz	w4, #0x7fff, lsl #16
+	movk	w4, #0xffff			// INT32_MAX
+	movz	w5, #1
+
+	// ADDS/SUBS/ANDS W: carry, signed overflow and borrow at bit 31.
+	adds	w3, w1, w2			// 0, Z and C
+	stur	x3, [x28]
+	bl	flags
+	adds	w6, w4, w5			// 0x80000000, N and V
+	stur	x6, [x28]
+	bl	flags
+	subs	w7, w5, w4			// 0x80000002, N, borrow
+	stur	x7, [x28]
+	bl	flags
+	subs	w8, w6, w5			// 0x7fffffff, C and V
+	stur	x8, [x28]
+	bl	flags
+	ands	w9, w1, w6			// 0x80000000, N; C and V cleared
+	stur	x9, [x28]
+	bl	flags
+
+	// ADD/SUB/AND, both widths, leave the flags alone.
+	mvn	x10, xzr
+	add	w10, w1, w2			// wraps to 0
+	stur	x10, [x28]
+	sub	w11, w5, w4			// 0x80000002
+	stur	x11, [x28]
+	and	w12, w1, w4			// 0x7ffffffe
+	stur	x12, [x28]
+	add	x13, x1, x2			// 0x100000000
+	stur	x13, [x28]
+	sub	x14, x5, x1			// -0xfffffffd
+	stur	x14, [x28]
+	and	x15, x1, x4			// 0x7ffffffe
+	stur	x15, [x28]
+	bl	flags				// still those of the ANDS
+
+	// ADD immediate, MVN, ORR and EOR W.
+	add	w16, w1, #3			// wraps to 1
+	stur	x16, [x28]
+	mvn	w17, w5				// 0xfffffffe
+	stur	x17, [x28]
+	orr	w18, w5, w4			// 0x7fffffff
+	stur	x18, [x28]
+	eor	w20, w1, w6			// 0x7ffffffe
+	stur	x20, [x28]
+
+	// LSL, LSR (UBFM) and ASR W shift within 32 bits.
+	lsl	w21, w4, #4			// 0xfffffff0
+	stur	x21, [x28]
+	lsr	w22, w1, #28			// 0xf
+	stur	x22, [x28]
+	asr	w23, w6, #4			// 0xf8000000, not sign-extended to 64 bits
+	stur	x23, [x28]
+
+	// LDUR/STUR W move four bytes and zero-extend.
+	movz	x24, #0x1000, lsl #16		// in the heap segment
+	mvn	x25, xzr
+	stur	x25, [x24]
+	stur	w5, [x24]			// low half only
+	ldur	x26, [x24]			// 0xffffffff00000001
+	stur	x26, [x28]
+	ldur	w27, [x24, #4]			// 0xffffffff
+	stur	x27, [x28]
+	stur	w6, [x28]			// a W store to the console prints 32 bits
+
+	mov	x30, x29
+	ret
+
+// Print NZCV as a number. Branches only, so the flags are read, not set.
+flags:
+	movz	x0, #0
+	b.pl	1f
+	add	x0, x0, #8
+1:	b.ne	2f
+	add	x0, x0, #4
+2:	b.cc	3f
+	add	x0, x0, #2
+3:	b.vc	4f
+	add	x0, x0, #1
+4:	stur	x0, [x28]
+	ret
+	.size	start, .-start
@@ -0,0 +1,253 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * guest_bench.c - Harness for the guest benchmarks in guest/.
+ *
+ * Runs each guest executable to completion (or until the instruction
+ * budget runs out) and prints one CSV line per benchmark: guest
+ * instructions, host time spent in runElf, host ns per guest instruction,
+ * MIPS, and the peak RSS of the run.
+ *
+ *   guest_bench [-b budget] [-J threshold] [-n] [-r runs] [-N cores,...]
+ *               [-c baseline] [-s baseline] [-T percent] [executable ...]
+ *
+ * -b, -J and -n mean what they do for ae, except that the budget defaults
+ * to 0 (no limit). With no executables, the whole suite is run.
+ *
+ * -N runs each benchmark once for each number of guest cores in the list,
+ * as ae -c does (see smp.h), and the last column gives the number. The
+ * instructions and MIPS are then those of all the cores together, and -J
+ * and -n have no effect, as multicore runs neither fuse nor translate.
+ * Without -N the last column is 0: the single-core run loop, as in ae
+ * without -c. Baselines are for the latter, so -N takes neither -c nor -s.
+ *
+ * With -r, each benchmark runs that many times; the time, MIPS and RSS
+ * columns are then medians, followed by the run count, the minimum and
+ * the 95% confidence half-width of the mean for MIPS and RSS.
+ *
+ * -s writes the median MIPS and RSS of each benchmark to a baseline file.
+ * -c compares against one, and the harness fails if any benchmark's
+ * median MIPS is more than -T percent (default 10) below its baseline,
+ * and significantly so.
+ * Baselines only mean something on the machine and with the flags they
+ * were recorded with; see the gate and baseline targets in the Makefile.
+ *
+ * Every run is a child process of its own, so that its peak RSS is not
+ * inflated by the ones before it. Guest output is discarded.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include "bench.h"
+
+#define MAX_RUNS 64
+#define MAX_BASELINE 64
+#define MAX_CORE_COUNTS 16
+
+static char *suite[] = {
+    "guest/crc",
+    "guest/list",
+    "guest/matmul",
+    "guest/sort",
+    "guest/strproc",
+};
+
+// What a child reports back to the harness.
+typedef struct result {
+    uint64_t    instrs;
+    double      ns;
+} result_t;
+
+// One line of a baseline file.
+typedef struct baseline {
+    char        name[64];
+    double      mips;
+    double      rss_kb;
+} baseline_t;
+
+static unsigned num_runs = 1;
+static double threshold = 10.0;
+static baseline_t baseline[MAX_BASELINE];
+static unsigned num_baseline;
+static FILE *save_file;
+static unsigned core_counts[MAX_CORE_COUNTS];
+static unsigned num_core_counts;
+
+static void run_child(const char *elf, const int fd) {
+    result_t r;
+    if (NULL == freopen("/dev/null", "w", stdout)) exit(EXIT_FAILURE);
+    bench_init_guest();
+    uint64_t entry = loadElf(elf);
+    double t0 = bench_now_ns();
+    runElf(entry);
+    r.ns = bench_now_ns() - t0;
+    r.instrs = num_instr;
+    if (write(fd, &r, sizeof(r)) != sizeof(r)) exit(EXIT_FAILURE);
+    exit(EXIT_SUCCESS);
+}
+
+static bool run_once(const char *elf, result_t *r, long *rss_kb) {
+    int fds[2];
+    struct rusage ru;
+    int status;
+    if (pipe(fds) < 0) return false;
+    fflush(NULL); // The child must not flush our buffers again.
+    pid_t pid = fork();
+    if (pid < 0) return false;
+    if (0 == pid) {
+        close(fds[0]);
+        run_child(elf, fds[1]);
+    }
+    close(fds[1]);
+    ssize_t n = read(fds[0], r, sizeof(*r));
+    close(fds[0]);
+    if (wait4(pid, &status, 0, &ru) < 0 || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS
+        || n != sizeof(*r)) {
+        fprintf(stderr, "%s: run failed\n", elf);
+        return false;
+    }
+    *rss_kb = ru.ru_maxrss;
+    return true;
+}
+
+// Half-width of the 95% confidence interval for the mean of n samples.
+static double ci95(const bench_stats_t *s, const unsigned n) {
+    static const double t[] = {0, 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228};
+    if (n < 2) return 0.0;
+    return (n - 1 < sizeof(t) / sizeof(t[0]) ? t[n - 1] : 1.96) * s->stddev / sqrt(n);
+}
+
+static bool load_baseline(const char *file) {
+    char line[256];
+    FILE *f = fopen(file, "r");
+    if (NULL == f) return false;
+    while (fgets(line, sizeof(line), f) && num_baseline < MAX_BASELINE) {
+        baseline_t *b = baseline + num_baseline;
+        if (3 == sscanf(line, "%63[^,],%lf,%lf", b->name, &b->mips, &b->rss_kb)) num_baseline++;
+    }
+    fclose(f);
+    return true;
+}
+
+/*
+ * Check a benchmark's MIPS against its baseline, if it has one. It fails
+ * only if the median is more than threshold percent down and the baseline
+ * lies above the confidence interval, so that one noisy run is not enough.
+ */
+
+static bool gate(const char *elf, const bench_stats_t *mips, const bench_stats_t *rss) {
+    for (unsigned i = 0; i < num_baseline; i++) {
+        const baseline_t *b = baseline + i;
+        if (strcmp(b->name, elf)) continue;
+        double change = 100.0 * (mips->median / b->mips - 1.0);
+        bool ok = change >= -threshold || mips->mean + ci95(mips, num_runs) >= b->mips;
+        fprintf(stderr, "gate: %-16s %8.2f MIPS vs %8.2f (%+.1f%%), RSS %+.1f%%: %s\n", elf,
+                mips->median, b->mips, change, 100.0 * (rss->median / b->rss_kb - 1.0), ok ? "ok" : "REGRESSION");
+        return ok;
+    }
+    if (num_baseline) fprintf(stderr, "gate: %-16s no baseline\n", elf);
+    return true;
+}
+
+static bool run_bench(const char *elf) {
+    double ns[MAX_RUNS], mips[MAX_RUNS], rss[MAX_RUNS];
+    result_t r;
+    long rss_kb;
+    for (unsigned i = 0; i < num_runs; i++) {
+        if (!run_once(elf, &r, &rss_kb)) return false;
+        ns[i] = r.ns;
+        mips[i] = r.ns > 0 ? 1e3 * r.instrs / r.ns : 0.0;
+        rss[i] = rss_kb;
+    }
+    bench_stats_t t = bench_summarize(ns, num_runs);
+    bench_stats_t m = bench_summarize(mips, num_runs);
+    bench_stats_t k = bench_summarize(rss, num_runs);
+    printf("%s,%lu,%.0f,%.2f,%.2f,%.0f,%u,%.2f,%.2f,%.0f,%.0f,%u\n", elf, r.instrs, t.median,
+           r.instrs ? t.median / r.instrs : 0.0, m.median, k.median,
+           num_runs, m.min, ci95(&m, num_runs), k.min, ci95(&k, num_runs), guest_cores);
+    if (save_file) fprintf(save_file, "%s,%.2f,%.0f\n", elf, m.median, k.median);
+    return gate(elf, &m, &k);
+}
+
+// Parse -N's comma-separated list of core counts.
+static bool parse_cores(char *list) {
+    for (char *c = strtok(list, ","); c; c = strtok(NULL, ",")) {
+        if (num_core_counts == MAX_CORE_COUNTS || 0 == (core_counts[num_core_counts++] = atoi(c)))
+            return false;
+    }
+    return 0 != num_core_counts;
+}
+
+// Run every benchmark asked for, or the whole suite.
+static bool run_all(const int argc, char *argv[]) {
+    bool ok = true;
+    if (optind < argc)
+        for (int i = optind; i < argc; i++) ok &= run_bench(argv[i]);
+    else
+        for (unsigned i = 0; i < sizeof(suite) / sizeof(suite[0]); i++) ok &= run_bench(suite[i]);
+    return ok;
+}
+
+int main(int argc, char *argv[]) {
+    int option;
+    bool ok = true;
+    max_num_instr = 0;
+    while ((option = getopt(argc, argv, "b:J:nr:N:c:s:T:")) != -1) {
+        switch (option) {
+            case 'b': max_num_instr = strtoull(optarg, NULL, 0); break;
+            case 'J': jit_threshold = atoi(optarg); break;
+            case 'n': no_fusion = true; break;
+            case 'r':
+                num_runs = atoi(optarg);
+                if (num_runs < 1) num_runs = 1;
+                if (num_runs > MAX_RUNS) num_runs = MAX_RUNS;
+                break;
+            case 'N':
+                if (!parse_cores(optarg)) {
+                    fprintf(stderr, "Bad core list %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 'c':
+                if (!load_baseline(optarg)) {
+                    fprintf(stderr, "Cannot read baseline %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                break;
+            case 's':
+                if (NULL == (save_file = fopen(optarg, "w"))) {
+                    fprintf(stderr, "Cannot write baseline %s\n", optarg);
+                    return EXIT_FAILURE;
+                }
+                fprintf(save_file, "benchmark,mips,peak_rss_kb\n");
+                break;
+            case 'T': threshold = atof(optarg); break;
+            default:
+                fprintf(stderr, "Usage: %s [-b budget] [-J threshold] [-n] [-r runs] [-N cores,...] "
+                        "[-c baseline] [-s baseline] [-T percent] [executable ...]\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (num_core_counts && (num_baseline || save_file)) {
+        fprintf(stderr, "-N takes neither -c nor -s\n");
+        return EXIT_FAILURE;
+    }
+    printf("benchmark,instrs,host_ns,ns_per_instr,mips,peak_rss_kb,"
+           "runs,mips_min,mips_ci95,rss_min_kb,rss_ci95_kb,cores\n");
+    if (0 == num_core_counts)
+        ok = run_all(argc, argv);
+    for (unsigned i = 0; i < num_core_counts; i++) {
+        guest_cores = core_counts[i];
+        ok &= run_all(argc, argv);
+    }
+    if (save_file) fclose(save_file);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,80 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * mem_bench.c - Microbenchmark for emulated memory accesses.
+ *
+ * Reports ns per access for the hit paths of mem_read_I and mem_write_L
+ * (the page is already allocated) over a small and a large working set,
+ * and for character and integer writes to IO_CHAR_ADDR. MMIO output goes
+ * to /dev/null while it is being timed.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include "bench.h"
+#include "ptable.h"
+
+#define DATA_ADDR 0x10000000ULL
+#define NUM_ACCESSES 200000
+#define NUM_MMIO 200000
+
+static uint64_t span;           // Bytes of the working set, a power of two.
+static volatile uint64_t sink;
+
+static void read_I(const unsigned n) {
+    uint64_t s = 0, off = 0;
+    for (unsigned i = 0; i < n; i++) {
+        s += mem_read_I(DATA_ADDR + off);
+        off = (off + 68) & (span - 1) & ~3ULL;
+    }
+    sink = s;
+}
+
+static void write_L(const unsigned n) {
+    uint64_t off = 0;
+    for (unsigned i = 0; i < n; i++) {
+        mem_write_L(DATA_ADDR + off, i);
+        off = (off + 72) & (span - 1) & ~7ULL;
+    }
+}
+
+static void mmio_write_B(const unsigned n) {
+    for (unsigned i = 0; i < n; i++) mem_write_B(IO_CHAR_ADDR, 'a' + i % 26);
+}
+
+static void mmio_write_L(const unsigned n) {
+    for (unsigned i = 0; i < n; i++) mem_write_L(IO_CHAR_ADDR, i);
+}
+
+int main(int argc, char *argv[]) {
+    static const uint64_t spans[] = {4096, 1 << 20};
+    char name[64];
+    bench_init_guest();
+    for (unsigned i = 0; i < sizeof(spans) / sizeof(spans[0]); i++) {
+        span = spans[i];
+        for (uint64_t a = 0; a < span; a += PAGESIZE) mem_write_B(DATA_ADDR + a, 0);
+        snprintf(name, sizeof(name), "mem/read_I/%luK", span / 1024);
+        bench_measure(name, read_I, NUM_ACCESSES);
+        snprintf(name, sizeof(name), "mem/write_L/%luK", span / 1024);
+        bench_measure(name, write_L, NUM_ACCESSES);
+    }
+
+    // Point stdout at /dev/null for the MMIO runs, keeping the report.
+    fflush(stdout);
+    int saved = dup(STDOUT_FILENO), null = open("/dev/null", O_WRONLY);
+    if (saved < 0 || null < 0) return EXIT_FAILURE;
+    bench_stats_t s[2];
+    dup2(null, STDOUT_FILENO);
+    s[0] = bench_measure("", mmio_write_B, NUM_MMIO);
+    s[1] = bench_measure("", mmio_write_L, NUM_MMIO);
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    bench_report("mem/mmio_write_B", s);
+    bench_report("mem/mmio_write_L", s + 1);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,81 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * ptable_bench.c - Microbenchmark for the page table.
+ *
+ * Grows the page table through a series of sizes and, at each, reports
+ * ns per add_page (for the pages that took it there) and per get_page,
+ * both for pages that are present (in random order) and for ones that
+ * are not. The table has a fixed number of hash buckets, so lookups slow
+ * down as it grows.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "ptable.h"
+
+#define BASE_PNUM 0x10000ULL   // The first page of the heap segment.
+#define NUM_PROBES 4096        // A power of two.
+
+// Lookups per sample shrink as the table grows, to keep run time sane.
+static const struct {
+    unsigned    pages;
+    unsigned    lookups;
+} sizes[] = {
+    {16, 200000},
+    {256, 100000},
+    {4096, 10000},
+    {16384, 2000},
+};
+
+static uint64_t num_pages;
+static uint64_t probes[NUM_PROBES];
+static volatile uint64_t sink;
+
+static uint64_t xorshift(uint64_t *x) {
+    *x ^= *x << 13;
+    *x ^= *x >> 7;
+    *x ^= *x << 17;
+    return *x;
+}
+
+static void add_pages(const unsigned n) {
+    for (unsigned i = 0; i < n; i++)
+        add_page(BASE_PNUM + num_pages++, 0x6);
+}
+
+static void get_pages(const unsigned n) {
+    uint64_t s = 0;
+    for (unsigned i = 0; i < n; i++) {
+        pte_ptr_t p = get_page(probes[i & (NUM_PROBES - 1)]);
+        s += p ? p->p_num : 1;
+    }
+    sink = s;
+}
+
+int main(int argc, char *argv[]) {
+    char name[64];
+    uint64_t x = 0x9E3779B97F4A7C15ULL;
+    for (unsigned i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        // One warm-up batch plus BENCH_REPS timed ones get to the next size.
+        unsigned batch = (sizes[i].pages - num_pages) / (BENCH_REPS + 1);
+        snprintf(name, sizeof(name), "ptable/add_page/%u", sizes[i].pages);
+        bench_measure(name, add_pages, batch);
+        add_pages(sizes[i].pages - num_pages);
+
+        for (unsigned j = 0; j < NUM_PROBES; j++)
+            probes[j] = BASE_PNUM + xorshift(&x) % num_pages;
+        snprintf(name, sizeof(name), "ptable/get_page/hit/%u", sizes[i].pages);
+        bench_measure(name, get_pages, sizes[i].lookups);
+
+        for (unsigned j = 0; j < NUM_PROBES; j++)
+            probes[j] = BASE_PNUM + num_pages + xorshift(&x) % num_pages;
+        snprintf(name, sizeof(name), "ptable/get_page/miss/%u", sizes[i].pages);
+        bench_measure(name, get_pages, sizes[i].lookups);
+    }
+    return EXIT_SUCCESS;
+}
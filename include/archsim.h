@@ -13,7 +13,7 @@
 #define _ARCHSIM_H_
 
 #define BUF_LEN 100
-#define MAX_NUM_INSTR 10000
+#define MAX_NUM_INSTR 10000ULL
 
 /* #include statements
  * The following #include lines will allow archsim.h to access the functions and
@@ -37,6 +37,14 @@
 #include "machine.h"
 #include "instr.h"
 #include "elf_loader.h"
+#include "trace.h"
+#include "fuse.h"
+#include "jit.h"
+#include "roi.h"
+#include "detail.h"
+#include "bbv.h"
+#include "sample.h"
+#include "smp.h"
 
 /* Function declarations
  * The following function declarations allow any file that #includes archsim.h
@@ -70,6 +78,70 @@ extern FILE *errfile;
 /* This is a string containing the prompt that will be displayed by the ci. */
 extern char *ae_prompt;
 
+/* The guest executable to run, and the file to write a binary trace to (NULL
+ * if tracing is off). Both are set by handle_args. 
+ */
+extern char *elf_file, *trace_file;
+
+/* If true, run every instruction through the stages individually instead of
+ * fusing common idioms. Set by the -n option.
+ */
+extern bool no_fusion;
+
+/* Number of times a block head must be reached before it is translated to
+ * host code, or 0 to interpret everything. Set by the -J option.
+ */
+extern unsigned jit_threshold;
+
+/* If true, statistics are only collected inside regions of interest the
+ * guest marks (see roi.h), rather than from the start of the run. Set by
+ * the -R option.
+ */
+extern bool roi_only;
+
+/* Number of guest instructions to run before stopping, or 0 for no limit.
+ * Defaults to MAX_NUM_INSTR; set by the -b option.
+ */
+extern uint64_t max_num_instr;
+
+/* Fast-forward before detailed simulation (see detail.h): for ff_instrs
+ * instructions if nonzero, or until PC reaches ff_until (a number or a
+ * symbol) if not NULL, whichever comes first. The first warmup_instrs
+ * detailed instructions only warm up the timing models. Set by the -f, -F
+ * and -w options.
+ */
+extern uint64_t ff_instrs;
+extern char *ff_until;
+extern uint64_t warmup_instrs;
+
+/* The file to write basic-block vectors to (see bbv.h), NULL if none, and
+ * the number of instructions in each of their intervals. Set by the -V
+ * and -I options.
+ */
+extern char *bbv_file;
+extern uint64_t bbv_interval;
+
+/* Sampled simulation (see sample.h): a sample every sample_period
+ * instructions (0 for none) of warmup_instrs plus sample_len instructions,
+ * with at most sample_jobs running at once (0 for one per CPU). Set by the
+ * -P, -L and -j options.
+ */
+extern uint64_t sample_period;
+extern uint64_t sample_len;
+extern unsigned sample_jobs;
+
+/* Number of guest cores, each run on a host thread of its own (see smp.h),
+ * or 0 without -c, and the instructions each runs per turn when they take
+ * turns, or 0 to let them run at once. Set by the -c and -d options.
+ */
+extern unsigned guest_cores;
+extern uint64_t smp_quantum;
+
+/* The configuration of the cache-coherence model of the guest cores (see
+ * coherence.h), or NULL for none. Set by the -C option.
+ */
+extern char *coh_config;
+
 /* These are booleans used to control program execution.
  * If ignore_input is true, the current input will no longer be processed. 
  * If terminate is true, the ae program will terminate. 
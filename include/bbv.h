@@ -0,0 +1,35 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * bbv.h - Header file for basic-block vector profiles.
+ *
+ * With -V, ae divides the run into intervals of a fixed number of
+ * instructions (-I) and writes, for each interval, how many instructions
+ * ran in each basic block, in SimPoint's .bb format:
+ *
+ *     T:<block id>:<instrs> :<block id>:<instrs> ...
+ *
+ * one line per interval, block ids counting from 1 in order of first
+ * execution. A block is identified by the PC it was entered at, as for
+ * the JIT. Intervals are positions in the whole run, so that interval i
+ * starts after exactly i * interval instructions whatever ran them; ROI
+ * markers do not affect the profile. tools/aesimpoint clusters the
+ * vectors and picks representative intervals to simulate in detail.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _BBV_H_
+#define _BBV_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define BBV_DEFAULT_INTERVAL 10000000ULL
+
+extern bool bbv_open(const char *path, const uint64_t interval);
+extern uint64_t bbv_room(void);
+extern void bbv_count(const uint64_t head, const unsigned n);
+extern void bbv_close(void);
+#endif
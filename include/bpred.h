@@ -0,0 +1,38 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * bpred.h - Header file for the conditional branch predictor models.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _BPRED_H_
+#define _BPRED_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef enum bpred_kind {
+    BP_NOT_TAKEN,   // Always predict fall-through.
+    BP_BIMODAL,     // Table of 2-bit counters indexed by PC.
+    BP_GSHARE,      // 2-bit counters indexed by PC xor global history.
+    BP_ERROR = -1
+} bpred_kind_t;
+
+typedef struct bpred {
+    bpred_kind_t kind;
+    unsigned    bits;       // log2 of the number of counters.
+    uint8_t     *table;     // 2-bit saturating counters.
+    uint64_t    ghist;      // Global history of conditional outcomes.
+// Statistics.
+    uint64_t    lookups;
+    uint64_t    mispredicts;
+} bpred_t;
+
+extern bpred_kind_t bpred_kind(const char *name);
+extern bool bpred_init(bpred_t *bp, const bpred_kind_t kind, const unsigned bits);
+extern void bpred_free(bpred_t *bp);
+extern void bpred_reset_stats(bpred_t *bp);
+extern bool bpred_update(bpred_t *bp, const uint64_t pc, const bool taken);
+#endif
@@ -0,0 +1,38 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * cache.h - Header file for the set-associative cache timing model.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _CACHE_H_
+#define _CACHE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// A write-back, write-allocate cache with LRU replacement.
+typedef struct cache {
+    unsigned    size;       // Capacity in bytes.
+    unsigned    assoc;      // Ways per set.
+    unsigned    line;       // Line size in bytes (power of two).
+    unsigned    num_sets;   // Number of sets (power of two).
+    unsigned    line_bits;  // log2(line).
+    uint64_t    *tags;      // num_sets*assoc line numbers; valid if stamp != 0.
+    uint64_t    *stamps;    // Last-use time per way; 0 means invalid.
+    bool        *dirty;     // Dirty bit per way.
+    uint64_t    tick;       // Access counter used for LRU stamps.
+    uint64_t    victim;     // Address of the last dirty line written back.
+// Statistics.
+    uint64_t    accesses;
+    uint64_t    misses;
+    uint64_t    writebacks;
+} cache_t;
+
+extern bool cache_init(cache_t *c, const unsigned size, const unsigned assoc, const unsigned line);
+extern void cache_free(cache_t *c);
+extern void cache_reset_stats(cache_t *c);
+extern bool cache_access(cache_t *c, const uint64_t addr, const unsigned width, const bool is_write);
+#endif
@@ -0,0 +1,124 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * coherence.h - Header file for the cache-coherence model of multicore
+ * guests.
+ *
+ * Each guest core (see smp.h) gets a private, set-associative data cache
+ * with LRU replacement, and the caches are kept coherent by snooping with
+ * the MESI or MOESI protocol. A read miss takes the line Exclusive if no
+ * other cache holds it and Shared otherwise; a Modified copy elsewhere
+ * supplies the data and, under MESI, is written back and becomes Shared,
+ * under MOESI becomes Owned and stays dirty. A write needs the only copy:
+ * a write miss, or a write to a Shared or Owned copy (an upgrade),
+ * invalidates every other copy, and a write to an Exclusive copy makes it
+ * Modified without telling anyone. Evicting a Modified or Owned line
+ * writes it back. The model is configured by a one-line string
+ *
+ *     mesi|moesi size=32K assoc=8 line=64 top=10
+ *
+ * with lines of at most 64 bytes. Sizes accept a K or M suffix, and
+ * omitted keys take the defaults shown.
+ *
+ * A miss is a coherence miss if the line left the cache because another
+ * core's write invalidated it, rather than by eviction. It is also false
+ * sharing if none of the bytes the access wants were written by the other
+ * cores: those the invalidating write covered and those written since by
+ * the cores that hold the line. Invalidations are charged to the line and
+ * the PC of the write that caused them, coherence misses and false sharing
+ * to those of the access that missed, and the top lines and PCs are
+ * reported.
+ *
+ * The model is not thread-safe; accesses from several cores' threads must
+ * be serialized by the caller, in the order they are made to memory.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _COHERENCE_H_
+#define _COHERENCE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define COH_MAX_LINE 64 // So that a line's bytes fit a uint64_t mask.
+
+typedef enum coh_protocol {
+    COH_MESI,
+    COH_MOESI,
+    COH_ERROR = -1
+} coh_protocol_t;
+
+typedef enum coh_state {
+    COH_I,
+    COH_S,
+    COH_E,
+    COH_O,
+    COH_M
+} coh_state_t;
+
+typedef struct coh_params {
+    coh_protocol_t protocol;
+    unsigned    size;       // Of each core's cache, in bytes.
+    unsigned    assoc;
+    unsigned    line;
+    unsigned    top;        // Lines and PCs to report.
+} coh_params_t;
+
+typedef struct coh_line {
+    uint64_t    lnum;       // Line number, valid unless state is COH_I and lost is false.
+    uint64_t    stamp;      // Time of last use, for LRU.
+    uint64_t    written;    // Bytes this core has written since it took the line for
+                            // writing; once lost, those the invalidating write covered.
+    coh_state_t state;
+    bool        lost;       // Invalidated by another core's write.
+} coh_line_t;
+
+// The events of one core.
+typedef struct coh_counts {
+    uint64_t    accesses;
+    uint64_t    misses;
+    uint64_t    coherence_misses;
+    uint64_t    false_sharing;
+    uint64_t    upgrades;       // Writes to Shared or Owned copies.
+    uint64_t    invalidations;  // Other cores' copies invalidated.
+    uint64_t    transfers;      // Misses another cache supplied the data for.
+    uint64_t    writebacks;
+} coh_counts_t;
+
+// The events charged to one line or PC.
+typedef struct coh_site {
+    uint64_t    key;        // Line number or PC, plus 1; 0 if the slot is free.
+    uint64_t    invalidations;
+    uint64_t    coherence_misses;
+    uint64_t    false_sharing;
+} coh_site_t;
+
+// Open-addressed hash table of sites.
+typedef struct coh_sites {
+    coh_site_t  *slots;
+    size_t      cap;        // A power of two.
+    size_t      used;
+} coh_sites_t;
+
+typedef struct coh {
+    coh_params_t p;
+    char        *config;
+    unsigned    num_cores;
+    unsigned    num_sets;
+    unsigned    line_bits;
+    coh_line_t  *lines;     // num_cores * num_sets * assoc.
+    uint64_t    now;
+    coh_counts_t *cores;    // Per core.
+    coh_sites_t by_line;
+    coh_sites_t by_pc;
+} coh_t;
+
+extern coh_t *coh_create(const char *config, const unsigned num_cores);
+extern void coh_free(coh_t *c);
+extern void coh_access(coh_t *c, const unsigned core, const uint64_t pc,
+                       const uint64_t addr, const unsigned width, const bool store);
+extern void coh_report(const coh_t *c, FILE *out);
+#endif
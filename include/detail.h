@@ -0,0 +1,37 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * detail.h - Header file for detailed simulation inside ae.
+ *
+ * Timing models (see timing.h) named with -m are fed every instruction
+ * ae retires once detailed simulation begins. By default it begins with
+ * the run; with -f or -F ae fast-forwards (fusing and translating code as
+ * usual) for a number of instructions or up to a PC, then switches to
+ * running every instruction through the stages. Architectural state is
+ * the same at the switch whichever way it was reached. The first -w
+ * detailed instructions only warm the models up: their statistics are
+ * zeroed when the warm-up ends.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _DETAIL_H_
+#define _DETAIL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "instr.h"
+#include "timing.h"
+
+#define DETAIL_MAX_MODELS 16
+
+extern bool detail_add_model(const char *config);
+extern unsigned detail_num_models(void);
+extern timing_model_t *detail_model(const unsigned i);
+extern uint64_t detail_stop_pc(const char *spec);
+extern void detail_begin(const uint64_t warmup);
+extern bool detail_warming(void);
+extern void detail_retire(const instr_t *insn, const uint64_t pc, const uint64_t next_pc);
+extern void detail_finish(void);
+#endif
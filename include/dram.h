@@ -0,0 +1,89 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * dram.h - Header file for the main-memory DRAM timing model.
+ *
+ * Lines missed in the last level of a core's caches are read from a DRAM
+ * of some channels, each with some banks, and dirty lines evicted from it
+ * are written back. Consecutive lines fill a row of one bank, and
+ * consecutive rows go to the next channel, then the next bank:
+ *
+ *     line address = row : bank : channel : column
+ *
+ * Each bank has a row buffer. Under the open-page policy a row stays open
+ * after an access, so an access to it needs only a column command (tCAS),
+ * an access to a closed bank an activate first (tRCD + tCAS), and one to
+ * another row a precharge as well (tRP + tRCD + tCAS). Under the
+ * closed-page policy every access activates its row and precharges it
+ * afterwards. Data then takes tBURST cycles on the channel's bus. All
+ * times are in core cycles.
+ *
+ * Reads are scheduled as the core makes them, ahead of writes. Writes
+ * wait in a per-channel queue, from which reads that hit are served; when
+ * it fills, it is drained to half full, first-ready first-come
+ * first-served: row hits before the oldest write.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _DRAM_H_
+#define _DRAM_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cache.h"
+
+typedef enum dram_policy {
+    DRAM_OPEN,      // Leave the row open after an access.
+    DRAM_CLOSED,    // Precharge after every access.
+    DRAM_ERROR = -1
+} dram_policy_t;
+
+typedef struct dram_params {
+    unsigned    channels;   // 0 for no DRAM model: a miss costs the core's miss latency only.
+    unsigned    banks;      // Per channel.
+    unsigned    row;        // Row buffer size in bytes.
+    dram_policy_t policy;
+    unsigned    trcd;       // Activate to column command.
+    unsigned    tcas;       // Column command to data.
+    unsigned    trp;        // Precharge to activate.
+    unsigned    tburst;     // Data transfer of one line.
+    unsigned    wq;         // Write queue entries per channel.
+} dram_params_t;
+
+typedef struct dram_bank {
+    uint64_t    open_row;   // Row in the row buffer, plus 1; 0 if precharged.
+    uint64_t    ready;      // Cycle the bank can take its next command.
+} dram_bank_t;
+
+typedef struct dram {
+    dram_params_t p;
+    unsigned    line_bits;  // log2 of the line size.
+    unsigned    cols;       // Lines per row.
+    dram_bank_t *banks;     // channels * banks.
+    uint64_t    *bus_free;  // Cycle each channel's data bus is next free.
+    uint64_t    *wq;        // channels * wq line numbers, oldest first.
+    unsigned    *wq_n;      // Writes queued per channel.
+// Statistics.
+    uint64_t    reads;
+    uint64_t    writes;
+    uint64_t    wq_hits;        // Reads served from the write queue.
+    uint64_t    row_hits;       // Accesses to the open row.
+    uint64_t    row_empty;      // Accesses to a precharged bank.
+    uint64_t    row_conflicts;  // Accesses that closed another row.
+    uint64_t    read_cycles;    // Summed latency of reads.
+} dram_t;
+
+static inline bool dram_enabled(const dram_t *d) {return 0 != d->p.channels;}
+
+extern dram_policy_t dram_policy(const char *name);
+extern bool dram_init(dram_t *d, const dram_params_t *p, const unsigned line);
+extern void dram_free(dram_t *d);
+extern void dram_reset_stats(dram_t *d);
+extern void dram_add_stats(dram_t *sum, const dram_t *d);
+extern uint64_t dram_read(dram_t *d, const uint64_t addr, const uint64_t t);
+extern void dram_write(dram_t *d, const uint64_t addr, const uint64_t t);
+extern uint64_t dram_fill(dram_t *d, const cache_t *c, const uint64_t writebacks,
+                          const uint64_t addr, const uint64_t t);
+#endif
@@ -3,4 +3,5 @@
 #include <stdint.h>
 
 extern uint64_t loadElf(const char *file);
+extern uint64_t elf_symbol(const char *file, const char *name);
 #endif
\ No newline at end of file
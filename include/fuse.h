@@ -0,0 +1,34 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * fuse.h - Header file for superinstruction fusion.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _FUSE_H_
+#define _FUSE_H_
+
+#include <stdint.h>
+#include "instr.h"
+
+// Recognized guest idioms.
+typedef enum fuse_kind {
+    FUSE_CMP_BRANCH,    // SUBS + B.cond
+    FUSE_MOVE_WIDE,     // MOVZ + up to three MOVKs to the same register
+    FUSE_ADDR_MEM,      // ADD (immediate) + LDUR/STUR/LDURB/STURB based on its result
+    FUSE_NUM_KINDS,
+    FUSE_ERROR = -1
+} fuse_kind_t;
+
+typedef struct fuse_stats {
+    uint64_t    groups[FUSE_NUM_KINDS];  // Fused groups executed, per idiom.
+    uint64_t    instrs[FUSE_NUM_KINDS];  // Guest instructions they covered.
+} fuse_stats_t;
+
+extern fuse_stats_t fuse_stats;
+
+extern unsigned fuse_exec(instr_t *const insn, const uint64_t budget);
+extern const char *fuse_name(const fuse_kind_t kind);
+#endif
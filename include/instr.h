@@ -20,6 +20,13 @@
 #define EXTRACT(src, mask, shift) (((src) & (mask)) >> (shift))
 #define GETBF(src, frompos, width) safe_GETBF(((int32_t) (src)), (frompos), (width))
 
+/* Map a 5-bit register field to an index into the register file. Field 31
+ * is SP for operands that allow it and the zero register otherwise; writes
+ * to the zero register go to a sink so that it keeps reading as zero. 
+ */
+#define REG_SRC(n, sp_ok) ((31 == (n)) ? ((sp_ok) ? R_SP : R_XZR) : (n))
+#define REG_DST(n, sp_ok) ((31 == (n)) ? ((sp_ok) ? R_SP : R_XZR_SINK) : (n))
+
 /* Used to set condition flags for flag setting instructions
  *
  * N: Negative condition flag
@@ -48,40 +55,24 @@
 //Overflow Condition flag
 #define GET_VF(cc) (((cc) >> 0)&0x1) 
 
+// One opcode per row of instr_spec.h, in the same order.
 typedef enum opcode {
     OP_NONE,
-    // Data transfer
-    OP_LDURB,
-    OP_LDUR,
-    OP_STURB,
-    OP_STUR,
-    OP_MOVK,
-    OP_MOVZ,
-    // Computation
-    OP_ADD_RI,
-    OP_ADDS_RR,
-    OP_SUBS_RR,
-    OP_MVN,
-    OP_ORR_RR,
-    OP_EOR_RR,
-    OP_ANDS_RR,
-    OP_LSL,
-    OP_LSR,
-    // LSL and LSR are implemented in terms of UBFM
-    OP_UBFM, 
-    OP_ASR,
-    // Control transfer
-    OP_B,
-    OP_B_COND,
-    OP_BL,
-    OP_RET,
-    // Misc
-    OP_NOP,
-    OP_HLT,
+#define INSTR(op, name, mask, value, is_32, fmt, ex, mem, wb, upc) OP_##op,
+#include "instr_spec.h"
+#undef INSTR
     OP_ERROR = -1
 } opcode_t;
 
 extern opcode_t itable[];
+extern opcode_t match_op(const uint32_t);
+
+// The opcode of instruction word w, from the itable unless several
+// opcodes share its entry.
+static inline opcode_t lookup_op(const uint32_t w) {
+    opcode_t op = itable[w >> 21];
+    return OP_NONE == op ? match_op(w) : op;
+}
 
 typedef enum cond {
     C_EQ,
@@ -130,9 +121,9 @@ typedef struct instr {
     opcode_t    op;         // Opcode.
     bool        is_32;      // Flag indicating whether this is the 32-bit version or 64-bit version of the instruction.
     cond_t      cond;       // Branch condition. Relevant only for branch instructions.
-    reg_t       *dst;       // Destination register (the one that is written in WB).
-    reg_t       *src1;      // Source register 1 (source of first input operand of EX).
-    reg_t       *src2;      // Source register 2 (source of second input operand of EX, or source of value for MEM write).
+    uint8_t     dst;        // Index of destination register (the one that is written in WB), or R_NONE.
+    uint8_t     src1;       // Index of source register 1 (source of first input operand of EX), or R_NONE.
+    uint8_t     src2;       // Index of source register 2 (source of second input operand of EX, or source of value for MEM write), or R_NONE.
     int64_t     imm;        // Immediate operand (second input operand of EX).
     uint8_t     shift;      // Shift amount, if any.
     uint64_t    next_PC;    // Address of next instruction to be executed. Generally PC+4, but not for B; undefined for RET.
@@ -161,4 +152,9 @@ extern void wback_instr(instr_t *const);
 extern void update_pc_instr(instr_t *const);
 extern void show_instr(const instr_t *, const proc_stage_t);
 extern void init_itable(void);
+
+// step_<op>(w): decode, execute, memory and writeback for a word already known to be op.
+#define INSTR(op, name, mask, value, is_32, fmt, ex, mem, wb, upc) extern void step_##op(const uint32_t);
+#include "instr_spec.h"
+#undef INSTR
 #endif
\ No newline at end of file
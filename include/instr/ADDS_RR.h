@@ -3,6 +3,6 @@
 #include <stdint.h>
 #include "../instr.h"
 
-extern void decode_ADDS_RR(instr_t * const);
 extern void execute_ADDS_RR(instr_t * const);
+extern void execute_ADDS_RR_W(instr_t * const);
 #endif
\ No newline at end of file
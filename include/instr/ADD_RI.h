@@ -3,6 +3,5 @@
 #include <stdint.h>
 #include "../instr.h"
 
-extern void decode_ADD_RI(instr_t * const);
 extern void execute_ADD_RI(instr_t * const);
 #endif
\ No newline at end of file
@@ -3,6 +3,5 @@
 #include <stdint.h>
 #include "../instr.h"
 
-extern void decode_B(instr_t * const);
 extern void execute_B(instr_t * const);
 #endif
\ No newline at end of file
@@ -3,6 +3,5 @@
 #include <stdint.h>
 #include "../instr.h"
 
-extern void decode_BL(instr_t * const);
 extern void execute_BL(instr_t * const);
 #endif
\ No newline at end of file
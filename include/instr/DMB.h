@@ -0,0 +1,7 @@
+#ifndef _DMB_H_
+#define _DMB_H_
+#include <stdint.h>
+#include "../instr.h"
+
+extern void execute_DMB(instr_t * const);
+#endif
\ No newline at end of file
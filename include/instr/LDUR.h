@@ -3,6 +3,5 @@
 #include <stdint.h>
 #include "../instr.h"
 
-extern void decode_LDUR(instr_t * const);
 extern void execute_LDUR(instr_t * const);
 #endif
\ No newline at end of file
@@ -0,0 +1,7 @@
+#ifndef _LDXR_H_
+#define _LDXR_H_
+#include <stdint.h>
+#include "../instr.h"
+
+extern void execute_LDXR(instr_t * const);
+#endif
\ No newline at end of file
@@ -3,6 +3,6 @@
 #include <stdint.h>
 #include "../instr.h"
 
-extern void decode_MVN(instr_t * const);
 extern void execute_MVN(instr_t * const);
+extern void execute_MVN_W(instr_t * const);
 #endif
\ No newline at end of file
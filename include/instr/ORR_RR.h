@@ -3,6 +3,6 @@
 #include <stdint.h>
 #include "../instr.h"
 
-extern void decode_ORR_RR(instr_t * const);
 extern void execute_ORR_RR(instr_t * const);
+extern void execute_ORR_RR_W(instr_t * const);
 #endif
\ No newline at end of file
@@ -0,0 +1,7 @@
+#ifndef _STXR_H_
+#define _STXR_H_
+#include <stdint.h>
+#include "../instr.h"
+
+extern void execute_STXR(instr_t * const);
+#endif
\ No newline at end of file
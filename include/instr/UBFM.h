@@ -3,6 +3,6 @@
 #include <stdint.h>
 #include "../instr.h"
 
-extern void decode_UBFM(instr_t * const);
 extern void execute_UBFM(instr_t * const);
+extern void execute_UBFM_W(instr_t * const);
 #endif
\ No newline at end of file
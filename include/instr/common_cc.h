@@ -0,0 +1,19 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ * 
+ * instr/common_cc.h - Header file for lazy condition-code evaluation.
+ * 
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/ 
+
+#ifndef _COMMON_CC_H_
+#define _COMMON_CC_H_
+#include <stdint.h>
+#include <stdbool.h>
+#include "../instr.h"
+
+extern uint8_t read_nzcv(void);
+extern void write_nzcv(const uint8_t);
+extern bool cond_holds(const cond_t);
+#endif
@@ -0,0 +1,34 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * instr/common_execute.h - Width specializations of execute handlers.
+ *
+ * EXECUTE_WX(op, expr) defines execute_<op>, the 64-bit (X) form, and
+ * execute_<op>_W, the 32-bit form, from one expression over the operands
+ * a and b. In the W form a and b are the low halves and the result is
+ * zero-extended, so neither handler looks at insn->is_32; which one runs
+ * is fixed by the opcode the decoder picks (see instr_spec.h).
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _COMMON_EXECUTE_H_
+#define _COMMON_EXECUTE_H_
+#include <stdint.h>
+#include "../instr.h"
+
+#define EXECUTE_WX(op, expr) \
+    void execute_##op(instr_t * const insn) { \
+        const uint64_t a = insn->opnd1.xval, b = insn->opnd2.xval; \
+        (void) a; (void) b; \
+        insn->val_ex.xval = (expr); \
+        return; \
+    } \
+    void execute_##op##_W(instr_t * const insn) { \
+        const uint32_t a = insn->opnd1.wval, b = insn->opnd2.wval; \
+        (void) a; (void) b; \
+        insn->val_ex.xval = (uint32_t) (expr); \
+        return; \
+    }
+#endif
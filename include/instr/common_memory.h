@@ -3,8 +3,14 @@
 #include "../instr.h"
 
 void common_memory_load_LX(instr_t * const);
+void common_memory_load_IW(instr_t * const);
 void common_memory_load_BW(instr_t * const);
 void common_memory_store_XL(instr_t * const);
+void common_memory_store_WI(instr_t * const);
 void common_memory_store_WB(instr_t * const);
+void common_memory_ldx_LX(instr_t * const);
+void common_memory_ldx_IW(instr_t * const);
+void common_memory_stx_XL(instr_t * const);
+void common_memory_stx_WI(instr_t * const);
 void common_memory_none(instr_t * const);
 #endif
\ No newline at end of file
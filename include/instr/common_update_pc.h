@@ -15,5 +15,7 @@ extern void update_pc_next(instr_t * const);
 extern void update_pc_halt(instr_t * const);
 
 // STUDENT TODO: Add other prototypes as needed below this line.
+extern void update_pc_branch(instr_t * const);
+extern void update_pc_target(instr_t * const);
 
 #endif
\ No newline at end of file
@@ -3,7 +3,9 @@
 #include "../instr.h"
 
 void common_writeback_alu_X(instr_t * const);
+void common_writeback_alu_X_cc(instr_t * const);
 void common_writeback_alu_W(instr_t * const);
+void common_writeback_alu_W_cc(instr_t * const);
 void common_writeback_mem_X(instr_t * const);
 void common_writeback_mem_W(instr_t * const);
 void common_writeback_none(instr_t * const);
@@ -0,0 +1,104 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * instr_spec.h - The instruction specification table.
+ *
+ * One INSTR row per opcode, in opcode order. Everything that used to be
+ * written out by hand per instruction is generated from this table: the
+ * opcode_t enum (instr.h), the itable, the decode, execute, memory,
+ * writeback and update-PC dispatchers, the step_<op> functions that
+ * aeaot's native code calls, and the opcode names (instr.c).
+ * Adding an instruction means adding a row here and writing its
+ * execute_* routine in instr/ (EXECUTE_WX in common_execute.h writes both
+ * widths of an ALU operation).
+ *
+ *   INSTR(op, name, mask, value, is_32, fmt, execute, memory, wback, update_pc)
+ *
+ *   op         OP_<op> in opcode_t.
+ *   name       Mnemonic, for disassembly.
+ *   mask/value An instruction word w encodes op iff (w & mask) == value.
+ *              The itable entries come from the top 11 bits of both; the
+ *              full match is checked when the instruction is decoded. An
+ *              entry that more than one opcode maps to is OP_NONE, and the
+ *              opcode is found by matching the whole word (lookup_op in
+ *              instr.h). A mask of 0 marks an alias that never appears in
+ *              the itable.
+ *   is_32      Whether this is the 32-bit form. The W and X forms of an
+ *              instruction are separate rows with their own handlers, so
+ *              the width is settled when the opcode is looked up and no
+ *              stage after decode tests it (disassembly still does).
+ *   fmt        Instruction format: which fields there are and which
+ *              registers and immediates decode reads (see instr.c).
+ *   execute, memory, wback, update_pc
+ *              The handlers for those stages.
+ *
+ * This file has no include guard: define INSTR, include it, then
+ * #undef INSTR.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+/*    op        name      mask        value       is_32  fmt        execute            memory                  wback                       update_pc */
+// Data transfer
+INSTR(LDURB,    "LDURB",  0xFFE00000, 0x38400000, false, F_LOAD,    execute_LDURB,     common_memory_load_BW,  common_writeback_mem_W,     update_pc_next)
+INSTR(LDUR,     "LDUR",   0xFFE00000, 0xF8400000, false, F_LOAD,    execute_LDUR,      common_memory_load_LX,  common_writeback_mem_X,     update_pc_next)
+INSTR(STURB,    "STURB",  0xFFE00000, 0x38000000, false, F_STORE,   execute_STURB,     common_memory_store_WB, common_writeback_none,      update_pc_next)
+INSTR(STUR,     "STUR",   0xFFE00000, 0xF8000000, false, F_STORE,   execute_STUR,      common_memory_store_XL, common_writeback_none,      update_pc_next)
+INSTR(MOVK,     "MOVK",   0xFF800000, 0xF2800000, false, F_MOVK,    execute_MOVK,      common_memory_none,     common_writeback_alu_X,     update_pc_next)
+INSTR(MOVZ,     "MOVZ",   0xFF800000, 0xD2800000, false, F_MOVZ,    execute_MOVZ,      common_memory_none,     common_writeback_alu_X,     update_pc_next)
+// Computation
+INSTR(ADD_RI,   "ADD",    0xFF800000, 0x91000000, false, F_ADD_IMM, execute_ADD_RI,    common_memory_none,     common_writeback_alu_X,     update_pc_next)
+INSTR(ADDS_RR,  "ADDS",   0xFFE00000, 0xAB000000, false, F_REG3,    execute_ADDS_RR,   common_memory_none,     common_writeback_alu_X_cc,  update_pc_next)
+INSTR(SUBS_RR,  "SUBS",   0xFFE00000, 0xEB000000, false, F_REG3,    execute_SUBS_RR,   common_memory_none,     common_writeback_alu_X_cc,  update_pc_next)
+INSTR(MVN,      "MVN",    0xFFE00000, 0xAA200000, false, F_REG2,    execute_MVN,       common_memory_none,     common_writeback_alu_X,     update_pc_next)
+INSTR(ORR_RR,   "ORR",    0xFFE00000, 0xAA000000, false, F_REG3,    execute_ORR_RR,    common_memory_none,     common_writeback_alu_X,     update_pc_next)
+INSTR(EOR_RR,   "EOR",    0xFFE00000, 0xCA000000, false, F_REG3,    execute_EOR_RR,    common_memory_none,     common_writeback_alu_X,     update_pc_next)
+INSTR(ANDS_RR,  "ANDS",   0xFFE00000, 0xEA000000, false, F_REG3,    execute_ANDS_RR,   common_memory_none,     common_writeback_alu_X_cc,  update_pc_next)
+// LSL and LSR are implemented in terms of UBFM
+INSTR(LSL,      "LSL",    0,          0,          false, F_ALIAS,   handler_none,      handler_none,           handler_none,               handler_none)
+INSTR(LSR,      "LSR",    0,          0,          false, F_ALIAS,   handler_none,      handler_none,           handler_none,               handler_none)
+INSTR(UBFM,     "UBFM",   0xFFC00000, 0xD3400000, false, F_BFM,     execute_UBFM,      common_memory_none,     common_writeback_alu_X,     update_pc_next)
+INSTR(ASR,      "ASR",    0xFFC0FC00, 0x9340FC00, false, F_ASR,     execute_ASR,       common_memory_none,     common_writeback_alu_X,     update_pc_next)
+// Control transfer
+INSTR(B,        "B",      0xFC000000, 0x14000000, false, F_B,       execute_B,         common_memory_none,     common_writeback_none,      update_pc_target)
+INSTR(B_COND,   "B.cond", 0xFF000010, 0x54000000, false, F_B_COND,  execute_B_COND,    common_memory_none,     common_writeback_none,      update_pc_branch)
+INSTR(BL,       "BL",     0xFC000000, 0x94000000, false, F_BL,      execute_BL,        common_memory_none,     common_writeback_alu_X,     update_pc_target)
+INSTR(RET,      "RET",    0xFFFFFC1F, 0xD65F0000, false, F_RET,     execute_RET,       common_memory_none,     common_writeback_none,      update_pc_branch)
+// Misc
+INSTR(NOP,      "NOP",    0xFFFFFFFF, 0xD503201F, false, F_NONE,    execute_NOP,       common_memory_none,     common_writeback_none,      update_pc_next)
+INSTR(HLT,      "HLT",    0xFFE0001F, 0xD4400000, false, F_HLT,     execute_HLT,       common_memory_none,     common_writeback_none,      update_pc_halt)
+// 32-bit (W) forms. Appended, so that the opcodes above keep their values.
+// LDUR, STUR, MOVZ, MOVK and ADD compute addresses or shift immediates the
+// same way at both widths, so only their memory or writeback handler differs.
+INSTR(LDUR_W,   "LDUR",   0xFFE00000, 0xB8400000, true,  F_LOAD,    execute_LDUR,      common_memory_load_IW,  common_writeback_mem_W,     update_pc_next)
+INSTR(STUR_W,   "STUR",   0xFFE00000, 0xB8000000, true,  F_STORE,   execute_STUR,      common_memory_store_WI, common_writeback_none,      update_pc_next)
+INSTR(MOVK_W,   "MOVK",   0xFFC00000, 0x72800000, true,  F_MOVK,    execute_MOVK,      common_memory_none,     common_writeback_alu_W,     update_pc_next)
+INSTR(MOVZ_W,   "MOVZ",   0xFFC00000, 0x52800000, true,  F_MOVZ,    execute_MOVZ,      common_memory_none,     common_writeback_alu_W,     update_pc_next)
+INSTR(ADD_RI_W, "ADD",    0xFF800000, 0x11000000, true,  F_ADD_IMM, execute_ADD_RI,    common_memory_none,     common_writeback_alu_W,     update_pc_next)
+INSTR(ADDS_RR_W,"ADDS",   0xFFE00000, 0x2B000000, true,  F_REG3,    execute_ADDS_RR_W, common_memory_none,     common_writeback_alu_W_cc,  update_pc_next)
+INSTR(SUBS_RR_W,"SUBS",   0xFFE00000, 0x6B000000, true,  F_REG3,    execute_SUBS_RR_W, common_memory_none,     common_writeback_alu_W_cc,  update_pc_next)
+INSTR(MVN_W,    "MVN",    0xFFE00000, 0x2A200000, true,  F_REG2,    execute_MVN_W,     common_memory_none,     common_writeback_alu_W,     update_pc_next)
+INSTR(ORR_RR_W, "ORR",    0xFFE00000, 0x2A000000, true,  F_REG3,    execute_ORR_RR_W,  common_memory_none,     common_writeback_alu_W,     update_pc_next)
+INSTR(EOR_RR_W, "EOR",    0xFFE00000, 0x4A000000, true,  F_REG3,    execute_EOR_RR_W,  common_memory_none,     common_writeback_alu_W,     update_pc_next)
+INSTR(ANDS_RR_W,"ANDS",   0xFFE00000, 0x6A000000, true,  F_REG3,    execute_ANDS_RR_W, common_memory_none,     common_writeback_alu_W_cc,  update_pc_next)
+INSTR(UBFM_W,   "UBFM",   0xFFC00000, 0x53000000, true,  F_BFM,     execute_UBFM_W,    common_memory_none,     common_writeback_alu_W,     update_pc_next)
+INSTR(ASR_W,    "ASR",    0xFFC0FC00, 0x13007C00, true,  F_ASR,     execute_ASR_W,     common_memory_none,     common_writeback_alu_W,     update_pc_next)
+// Non-flag-setting forms of ADDS, SUBS and ANDS. They share the execute
+// handler of the flag-setting form and differ only in writeback.
+INSTR(ADD_RR,   "ADD",    0xFFE00000, 0x8B000000, false, F_REG3,    execute_ADDS_RR,   common_memory_none,     common_writeback_alu_X,     update_pc_next)
+INSTR(SUB_RR,   "SUB",    0xFFE00000, 0xCB000000, false, F_REG3,    execute_SUBS_RR,   common_memory_none,     common_writeback_alu_X,     update_pc_next)
+INSTR(AND_RR,   "AND",    0xFFE00000, 0x8A000000, false, F_REG3,    execute_ANDS_RR,   common_memory_none,     common_writeback_alu_X,     update_pc_next)
+INSTR(ADD_RR_W, "ADD",    0xFFE00000, 0x0B000000, true,  F_REG3,    execute_ADDS_RR_W, common_memory_none,     common_writeback_alu_W,     update_pc_next)
+INSTR(SUB_RR_W, "SUB",    0xFFE00000, 0x4B000000, true,  F_REG3,    execute_SUBS_RR_W, common_memory_none,     common_writeback_alu_W,     update_pc_next)
+INSTR(AND_RR_W, "AND",    0xFFE00000, 0x0A000000, true,  F_REG3,    execute_ANDS_RR_W, common_memory_none,     common_writeback_alu_W,     update_pc_next)
+// Exclusive loads and stores and barriers, for guests that run on more than
+// one core (see smp.h). DMB, DSB and ISB share their itable entry with NOP.
+// An ISB has nothing to wait for, so it is one.
+INSTR(LDXR,     "LDXR",   0xFFFFFC00, 0xC85F7C00, false, F_LDX,     execute_LDXR,      common_memory_ldx_LX,   common_writeback_mem_X,     update_pc_next)
+INSTR(LDXR_W,   "LDXR",   0xFFFFFC00, 0x885F7C00, true,  F_LDX,     execute_LDXR,      common_memory_ldx_IW,   common_writeback_mem_W,     update_pc_next)
+INSTR(STXR,     "STXR",   0xFFE0FC00, 0xC8007C00, false, F_STX,     execute_STXR,      common_memory_stx_XL,   common_writeback_mem_W,     update_pc_next)
+INSTR(STXR_W,   "STXR",   0xFFE0FC00, 0x88007C00, true,  F_STX,     execute_STXR,      common_memory_stx_WI,   common_writeback_mem_W,     update_pc_next)
+INSTR(DMB,      "DMB",    0xFFFFF0FF, 0xD50330BF, false, F_NONE,    execute_DMB,       common_memory_none,     common_writeback_none,      update_pc_next)
+INSTR(DSB,      "DSB",    0xFFFFF0FF, 0xD503309F, false, F_NONE,    execute_DMB,       common_memory_none,     common_writeback_none,      update_pc_next)
+INSTR(ISB,      "ISB",    0xFFFFF0FF, 0xD50330DF, false, F_NONE,    execute_NOP,       common_memory_none,     common_writeback_none,      update_pc_next)
@@ -33,7 +33,11 @@
 #include "RET.h"
 #include "NOP.h"
 #include "HLT.h"
+#include "LDXR.h"
+#include "STXR.h"
+#include "DMB.h"
 #include "common_memory.h"
 #include "common_writeback.h"
 #include "common_update_pc.h"
+#include "common_cc.h"
 #endif
\ No newline at end of file
@@ -0,0 +1,35 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * jit.h - Header file for the x86-64 translation tier.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _JIT_H_
+#define _JIT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct jit_stats {
+    uint64_t    blocks;     // Blocks translated.
+    uint64_t    instrs;     // Guest instructions executed as translated code.
+    uint64_t    entries;    // Transitions from the interpreter into translated code.
+    uint64_t    chains;     // Block exits patched to jump straight to their target.
+    uint64_t    flushes;    // Times the code cache was emptied.
+    uint64_t    smc_flushes; // Of those, because the guest stored to translated code.
+    uint64_t    code_bytes; // Host code emitted.
+} jit_stats_t;
+
+extern jit_stats_t jit_stats;
+
+// Set by a store to a page holding translated code. jit_run then throws
+// every translation away before running more code.
+extern bool jit_stale;
+
+extern bool jit_init(const unsigned threshold);
+extern void jit_set_barrier(const uint64_t pc);
+extern uint64_t jit_run(const uint64_t budget);
+#endif
@@ -11,7 +11,9 @@ typedef enum {
     MODE_ERR = -1
 } machine_mode_t;
 
-// Machine state.
+// Machine state. Every host thread running a guest core has its own copy
+// of the global guest, differing only in proc, which points at that core's
+// entry in procs; mem and everything else are shared.
 typedef struct machine {
     char *name;
     unsigned word_size;
@@ -19,8 +21,11 @@ typedef struct machine {
     byte_order_t data_order;
     machine_mode_t mode;
     proc_t *proc;
+    unsigned num_cores;
+    proc_t *procs;      // num_cores processors; procs[0] is the boot core.
     mem_t *mem;
 } machine_t;
 
 extern void init_machine(char *, unsigned, byte_order_t, byte_order_t);
+extern void init_cores(const unsigned);
 #endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define _MEM_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 // Memory state.
 typedef enum {
     L_ENDIAN,
@@ -52,6 +53,13 @@ extern write_ret_code_t mem_write_I (uint64_t address, int       data);
 extern write_ret_code_t mem_write_L (uint64_t address, long      data);
 extern write_ret_code_t mem_write_LL(uint64_t address, long long data);
 
+// Exclusive access (LDXR, STXR) of 4 or 8 naturally aligned bytes. The
+// write returns true if it was made, which it is only if the current
+// core's last exclusive read was of the same bytes and they still hold
+// the value it read.
+extern uint64_t mem_read_excl(uint64_t address, unsigned width);
+extern bool mem_write_excl(uint64_t address, uint64_t data, unsigned width);
+
 extern const uint64_t NULL_ADDR;
 extern const uint64_t IO_CHAR_ADDR;
 extern const uint64_t RET_FROM_MAIN_ADDR;
@@ -0,0 +1,67 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * mmio.h - Header file for memory-mapped devices.
+ *
+ * Devices live in a reserved part of the address space: the top
+ * MMIO_SIZE bytes, plus address 0 so that null pointers can be caught.
+ * mmio_is_reserved tells the two apart from ordinary memory with a single
+ * unsigned compare, so loads and stores elsewhere never look at the device
+ * table. An address in the reserved region that no device claims is
+ * ordinary memory.
+ *
+ * Built-in devices:
+ *
+ *   NULL_ADDR           Null: reads are fatal, writes are logged.
+ *   IO_CHAR_ADDR        Console: bytes are characters, wider accesses
+ *                       decimal integers, one per line.
+ *   RET_FROM_MAIN_ADDR  Return from main: a branch target only.
+ *   MMIO_COUNTERS       Read-only 64-bit counters for guests that time
+ *                       themselves, at the offsets below. Writes are
+ *                       ignored. They sit within LDUR range of
+ *                       IO_CHAR_ADDR, so a guest that keeps -1 in a
+ *                       register needs no extra instructions to reach them.
+ *   MMIO_ROI            Region-of-interest markers; see roi.h.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _MMIO_H_
+#define _MMIO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "mem.h"
+
+#define MMIO_SIZE 0x10000ULL
+#define MMIO_BASE (0ULL - MMIO_SIZE)
+#define MMIO_MAX_DEVS 16
+
+#define MMIO_COUNTERS       0xFFFFFFFFFFFFFF00ULL
+#define MMIO_CTR_INSTRET    0x00    // Guest instructions retired before this load.
+#define MMIO_CTR_CYCLES     0x08    // Virtual cycles. ae models one per instruction.
+#define MMIO_CTR_HOST_NS    0x10    // Host monotonic clock, in ns.
+#define MMIO_CTR_SIZE       0x18
+
+typedef struct mmio_dev mmio_dev_t;
+
+// Accessors get the offset of the access from the device's base address.
+typedef uint64_t (*mmio_read_fn)(mmio_dev_t *dev, const uint64_t off, const unsigned width);
+typedef mrc_t (*mmio_write_fn)(mmio_dev_t *dev, const uint64_t off, const uint64_t data, const unsigned width);
+
+struct mmio_dev {
+    const char      *name;
+    uint64_t        base;   // First address the device claims.
+    uint64_t        size;   // Number of addresses it claims.
+    mmio_read_fn    read;
+    mmio_write_fn   write;
+    void            *ctx;   // Device state, for the accessors.
+};
+
+// Address 0 and [MMIO_BASE, 2^64), in one compare: 0 - 1 wraps around.
+static inline bool mmio_is_reserved(const uint64_t addr) {return addr - 1 >= MMIO_BASE - 1;}
+
+extern bool mmio_register(const mmio_dev_t *dev);
+extern mmio_dev_t *mmio_find(const uint64_t addr);
+#endif
@@ -0,0 +1,131 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * ooo.h - Header file for the out-of-order core timing model.
+ *
+ * The model schedules each retired instruction through five events, in
+ * the manner of a trace-driven dataflow model: fetch, dispatch (rename
+ * and allocation), issue, completion and retirement. Fetch, dispatch and
+ * retirement are in order and limited by their widths; issue is out of
+ * order, as soon as the operands are ready, subject to the issue width
+ * and to the number of memory ports. An instruction cannot dispatch until
+ * there is room for it in the reorder buffer, the issue queue, the
+ * load/store queue (loads and stores) and the physical register file
+ * (instructions that write a register or the flags).
+ *
+ * Physical registers beyond the architectural ones are held from dispatch
+ * until retirement. NZCV is renamed like a register: ADDS, SUBS and ANDS
+ * write it and B.cond reads it.
+ *
+ * Only the correct path is seen, so a mispredicted B.cond holds up the
+ * fetch of its successor until it completes, plus the mispredict penalty;
+ * any other taken transfer ends the fetch group, plus the taken penalty.
+ * Loads know the addresses of older stores (perfect disambiguation). A
+ * load covered by a store still in the queue gets its data forwarded
+ * once the store's data is ready; one that overlaps such a store only in
+ * part waits for the store to retire. Stores write the L1D at retirement
+ * and never stall. With a DRAM model (see dram.h), L1 misses and
+ * writebacks go to it after the miss latency. With TLBs (see tlb.h), a
+ * fetch waits for its translation and a load's latency includes its
+ * own; a store is translated at retirement.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _OOO_H_
+#define _OOO_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "trace.h"
+#include "cache.h"
+#include "bpred.h"
+#include "dram.h"
+#include "tlb.h"
+
+#define OOO_ARCH_REGS 33    // X0-X30, SP and NZCV.
+#define OOO_NZCV 32         // Index of NZCV among the architectural registers.
+#define OOO_FETCH_BUF 4     // Fetch buffer, in fetch groups.
+#define OOO_CAL_SIZE 4096   // Cycles ahead the issue calendar covers (a power of two).
+#define OOO_MAX_WIDTH 64
+
+// Functional-unit classes, each with its own latency.
+typedef enum fu_class {
+    FU_ALU,
+    FU_BRANCH,
+    FU_LOAD,        // Latency of an L1D hit or a forwarded store.
+    FU_STORE,
+    NUM_FU_CLASSES
+} fu_class_t;
+
+typedef struct ooo_params {
+    unsigned    fetch;          // Instructions fetched and dispatched per cycle.
+    unsigned    issue;          // Instructions issued per cycle.
+    unsigned    retire;         // Instructions retired per cycle.
+    unsigned    rob;            // Reorder buffer entries.
+    unsigned    iq;             // Issue queue entries.
+    unsigned    prf;            // Physical registers, at least OOO_ARCH_REGS + 1.
+    unsigned    lsq;            // Load/store queue entries.
+    unsigned    ports;          // Loads and stores issued per cycle.
+    unsigned    lat[NUM_FU_CLASSES];
+    unsigned    miss_lat;       // Cycles added by an L1 miss, before any DRAM latency.
+    unsigned    mispredict_pen; // Cycles from resolving a mispredicted B.cond to refetch.
+    unsigned    taken_pen;      // Fetch bubble after a correctly predicted taken transfer.
+} ooo_params_t;
+
+// A load or store in the load/store queue.
+typedef struct ooo_mem_op {
+    uint64_t    addr;
+    uint64_t    ready;      // Cycle a store's data can be forwarded.
+    uint64_t    retire;     // Cycle it leaves the queue.
+    uint8_t     width;
+    bool        is_store;
+} ooo_mem_op_t;
+
+// Instructions issued in one cycle.
+typedef struct ooo_slot {
+    uint64_t    cycle;
+    uint16_t    issued;
+    uint16_t    mem;
+} ooo_slot_t;
+
+typedef struct ooo {
+    ooo_params_t p;
+    cache_t     l1i;
+    cache_t     l1d;
+    bpred_t     bp;
+    dram_t      dram;       // Behind both L1s, if enabled.
+    tlb_t       tlb;        // In front of both L1s, if enabled.
+// Pipeline state. Times are absolute cycles.
+    uint64_t    reg_ready[OOO_ARCH_REGS];   // Cycle each register's latest value is ready.
+    uint64_t    fetch_cycle, disp_cycle, retire_cycle;
+    unsigned    fetch_n, disp_n, retire_n;  // Instructions handled so far in those cycles.
+    uint64_t    redirect;   // Earliest fetch after the last branch.
+    uint64_t    *fq;        // Dispatch times of the last fetch-buffer-full of instructions.
+    uint64_t    *rob_q;     // Retire times of the last rob instructions.
+    uint64_t    *ren_q;     // Retire times of the last prf - OOO_ARCH_REGS writers.
+    ooo_mem_op_t *lsq_q;    // The last lsq loads and stores.
+    unsigned    fq_head, rob_head, ren_head, lsq_head;  // Oldest entry of each.
+    unsigned    fq_size, ren_size;
+    uint64_t    *iq_heap;   // Min-heap of issue times of instructions that may still be queued.
+    unsigned    iq_n;
+    ooo_slot_t  *cal;       // Issue calendar, indexed by cycle modulo OOO_CAL_SIZE.
+// Statistics.
+    uint64_t    cycles;     // Cycles up to the last retirement.
+    uint64_t    rob_occ;    // Sums of cycles spent in each structure; over cycles,
+    uint64_t    iq_occ;     // the average occupancy.
+    uint64_t    lsq_occ;
+    uint64_t    stall_rob;  // Dispatch cycles lost waiting for each structure.
+    uint64_t    stall_iq;
+    uint64_t    stall_prf;
+    uint64_t    stall_lsq;
+    uint64_t    forwards;   // Loads satisfied from the store queue.
+} ooo_t;
+
+extern bool ooo_init(ooo_t *o, const ooo_params_t *p);
+extern void ooo_free(ooo_t *o);
+extern void ooo_reset_stats(ooo_t *o);
+extern void ooo_add_stats(ooo_t *sum, const ooo_t *o);
+extern void ooo_consume(ooo_t *o, const trace_rec_t *rec);
+#endif
@@ -1,16 +1,33 @@
 #ifndef _PROC_H_
 #define _PROC_H_
 #include <stdint.h>
+#include <stdbool.h>
 #include "reg.h"
+#include "instr.h"
 
-// Processor state.
+// Processor state: one contiguous register file, indexed by the R_* values
+// in reg.h, aligned so that it starts on a cache line.
+//
+// NZCV is evaluated lazily. A flag-setting instruction records its opcode,
+// operands and result in cc_*, and regs[R_NZCV] is only brought up to date
+// (by read_nzcv) when something reads it. cc_op == OP_NONE means
+// regs[R_NZCV] is current; otherwise it also says which width the flags
+// are for (OP_*_W for the 32-bit forms).
 typedef struct proc {
-    reg_file_t GPR;
-    // reg_file_t FPR;
-    reg_t PC;
-    reg_t SP;
-    reg_t NZCV;
-} proc_t;
+    gpregval_t regs[NUM_REGS];
+    opcode_t    cc_op;      // Flag-setting opcode whose flags are pending.
+    uint64_t    cc_opnd1;
+    uint64_t    cc_opnd2;
+    uint64_t    cc_res;
+// The exclusive monitor (see mem_read_excl in mem.c).
+    uint64_t    excl_addr;  // Address of the last load-exclusive.
+    uint64_t    excl_val;   // The value it read.
+    unsigned    excl_width; // Its width in bytes, or 0 if the monitor is clear.
+} __attribute__((aligned(64))) proc_t;
+
+// Guest instructions run by the last call to runElf. Each guest core's
+// thread counts its own (see smp.h); the total is left in the main thread's.
+extern __thread uint64_t num_instr;
 
 extern int runElf(const uint64_t);
-#endif
\ No newline at end of file
+#endif
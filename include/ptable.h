@@ -1,6 +1,7 @@
 #ifndef _PTABLE_H_
 #define _PTABLE_H_
 #include <stdint.h>
+#include <stdbool.h>
 
 #define PAGESIZE 4096
 
@@ -8,6 +9,7 @@ typedef struct pte {
     uint64_t p_num;
     unsigned p_prot;
     char *p_data;
+    bool p_code;    // Holds guest code the JIT has translated.
     struct pte *p_next;
 } pte_t, *pte_ptr_t;
 
@@ -2,6 +2,7 @@
 #define _REG_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 
 typedef enum wvar {
     WVAR_4,
@@ -17,26 +18,20 @@ typedef union gpregval {
     int64_t xval;
 } gpregval_t, val_t;// TODO: Check dependence on endian-ness.
 
-// A single register.
-typedef struct reg {
-    char        *name;  // The name of the register.
-    unsigned    index;  // An index into a register file.
-    wvar_t      width;  // Bit width of the register.
-    gpregval_t  *bits;   // A pointer to the bit storage.
-} reg_t;
-
-// Register file.
-typedef struct reg_file {
-    char        *name;  // Name of the register file.
-    unsigned    num;    // How many registers in the file.
-    unsigned    width;  // How wide is each register?
-    gpregval_t  *bits;  // Storage area for the bits. Allocate an array of "num" gpregval_t structs.
-    reg_t       *names32;
-    reg_t       *names64;
-} reg_file_t;
+/* Register indices into the flat register file in proc_t.
+ * 0-30 are X0-X30. Register field 31 of an instruction names either SP or
+ * the zero register; the decoder resolves which and emits R_SP, R_XZR (for
+ * reads) or R_XZR_SINK (for writes, which are thrown away). 
+ */
+#define R_SP        31
+#define R_PC        32
+#define R_NZCV      33
+#define R_XZR       34  // Always reads as zero.
+#define R_XZR_SINK  35  // Target of writes to the zero register; never read.
+#define NUM_REGS    36
+#define R_NONE      0xFFU // No register operand.
 
 extern char *reg_prefix[];
 
-extern void init_reg(reg_t *r, char *name, unsigned index, wvar_t width, gpregval_t *bits);
-extern void init_reg_file(reg_file_t *rf, char *name, unsigned num, unsigned width);
-#endif
\ No newline at end of file
+extern const char *reg_name(const unsigned index, const bool is_32);
+#endif
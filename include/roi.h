@@ -0,0 +1,55 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * roi.h - Header file for guest-marked regions of interest.
+ *
+ * A guest brackets the code it wants measured by storing (any value) to
+ * the ROI device registers, in the manner of gem5's m5ops:
+ *
+ *   MMIO_ROI + MMIO_ROI_RESET  Zero the statistics.
+ *   MMIO_ROI + MMIO_ROI_START  Start collecting statistics.
+ *   MMIO_ROI + MMIO_ROI_STOP   Stop collecting statistics.
+ *   MMIO_ROI + MMIO_ROI_DUMP   Log the statistics so far.
+ *
+ * Reading any of them gives 1 while statistics are being collected.
+ * Collection is on from the start of the run unless ae was given -R.
+ * Anything that accumulates statistics (the trace, timing models) is to
+ * look at roi_active.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _ROI_H_
+#define _ROI_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "mmio.h"
+
+#define MMIO_ROI        0xFFFFFFFFFFFFFF20ULL
+#define MMIO_ROI_RESET  0x00
+#define MMIO_ROI_START  0x08
+#define MMIO_ROI_STOP   0x10
+#define MMIO_ROI_DUMP   0x18
+#define MMIO_ROI_SIZE   0x20
+
+typedef struct roi_stats {
+    unsigned    regions;    // Times collection was started.
+    uint64_t    instrs;     // Guest instructions retired while collecting.
+    double      secs;       // Host time spent collecting.
+} roi_stats_t;
+
+extern bool roi_active;
+
+extern void roi_init(const bool active);
+extern void roi_start(void);
+extern void roi_stop(void);
+extern void roi_reset(void);
+extern void roi_dump(const char *what);
+extern void roi_finish(void);
+extern roi_stats_t roi_get_stats(void);
+
+extern uint64_t roi_read(mmio_dev_t *dev, const uint64_t off, const unsigned width);
+extern mrc_t roi_write(mmio_dev_t *dev, const uint64_t off, const uint64_t data, const unsigned width);
+#endif
@@ -0,0 +1,35 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * sample.h - Header file for parallel sampled simulation.
+ *
+ * With -P, ae runs the program once on the fast path and, every P
+ * instructions, checkpoints it by forking. Each child runs the next -w
+ * instructions to warm up the timing models (-m) and the -L after that in
+ * detail, sends the models' statistics back and exits, while the parent
+ * carries on. At most -j children run at once. At the end the parent
+ * reports the models' statistics summed over the samples, and for each
+ * model the mean of its per-sample figure of merit (see
+ * timing_model_metric) with a 95% confidence interval.
+ *
+ * Samples see the guest's memory and registers as they were at their
+ * checkpoint, copy-on-write. Their console output is discarded, and they
+ * must not read the console.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _SAMPLE_H_
+#define _SAMPLE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SAMPLE_DEFAULT_LEN 10000ULL
+
+extern bool sample_init(const unsigned jobs);
+extern bool sample_fork(void);
+extern void sample_child_exit(void);
+extern void sample_finish(void);
+#endif
@@ -0,0 +1,46 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * smp.h - Header file for running a guest on more than one core.
+ *
+ * With -c n, ae runs n guest cores, each on its own host thread, sharing
+ * the guest's memory. Every core starts at the entry point with registers
+ * of its own: X0 its number, from 0 to n - 1, X1 n, SP the top of its own
+ * SMP_STACK_SIZE bytes of stack, below the boot core's, and X30 the
+ * return address that ends the run. -c 1 runs this way too, so that a
+ * guest written for any number of cores can run on one. The run ends once every core
+ * has returned from main or run -b instructions. HLT on any core stops
+ * every core at its next instruction; the run is then reported as usual,
+ * and ae exits with failure status, as after HLT on a single core.
+ *
+ * Cores synchronize through LDXR/STXR and DMB (see mem_read_excl in
+ * mem.c). Left to themselves the threads interleave however the host
+ * schedules them, so no two runs need agree. With -d q they instead take
+ * turns in core order, q instructions at a time, one thread running at
+ * once, so that every run of a guest interleaves the same way: slower,
+ * but reproducible for debugging.
+ *
+ * -C config models the coherence of the cores' data caches (see
+ * coherence.h), and reports it at the end of the run; it runs even a
+ * single core this way. The model sees every data access in the order it
+ * was made, but the counts are reproducible under -d only, as the
+ * interleaving is.
+ *
+ * Multicore runs are interpreted, neither fusing nor translating, and
+ * take none of -t, -m, -V, -P, -f, -F and -R.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _SMP_H_
+#define _SMP_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SMP_STACK_SIZE (1ULL << 24)
+
+extern int smp_run(const uint64_t entry);
+extern bool smp_halt(void);
+#endif
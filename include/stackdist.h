@@ -0,0 +1,69 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * stackdist.h - Header file for the LRU stack-distance cache sweep.
+ *
+ * One pass over the access stream gives the miss ratio of every LRU cache
+ * with a given line size whose capacity is a power of two between min and
+ * max bytes, fully associative or with any power-of-two associativity up
+ * to assoc.
+ *
+ * Fully associative: the stack distance of an access (distinct lines
+ * touched since the previous access to its line) is found with Olken's
+ * algorithm, a Fenwick tree over access times in which only the latest
+ * access to each line is marked, in O(log n) time. An access misses in a
+ * cache of C lines if and only if its distance is at least C, so a
+ * histogram of distances by powers of two gives all capacities at once.
+ *
+ * Set associative: a cache of S sets misses if and only if the distance
+ * within the access's set is at least the associativity, so for each set
+ * count in range the sweep keeps each set's most recent lines, as many as
+ * the largest cache of that set count can hold, and counts hits by stack
+ * position.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _STACKDIST_H_
+#define _STACKDIST_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SD_MAX_ASSOC 32
+#define SD_MAX_SET_BITS 31  // Up to 2^31 sets.
+#define SD_DIST_BUCKETS 65  // Distances by number of significant bits.
+
+typedef struct stackdist {
+    unsigned    line_bits;  // log2(line size).
+    unsigned    min_bits;   // log2(smallest capacity in lines).
+    unsigned    max_bits;   // log2(largest capacity in lines).
+    unsigned    assoc;      // Largest associativity, a power of two.
+    unsigned    set_lo;     // log2 of the fewest sets tracked.
+// Fully associative.
+    uint32_t    *tree;      // Fenwick tree over access times, 1-based.
+    uint64_t    cap;        // Times available before renumbering.
+    uint64_t    now;        // Time of the next access.
+    uint64_t    *keys;      // Open-addressed table: line + 1, or 0 if empty.
+    uint64_t    *times;     // Time of each line's latest access.
+    uint64_t    hash_size;  // A power of two.
+    uint64_t    num_lines;
+// Set associative: per set count, each set's lines, most recent first.
+    uint64_t    *stacks[SD_MAX_SET_BITS + 1];
+    unsigned    depth[SD_MAX_SET_BITS + 1];
+// Statistics.
+    uint64_t    accesses;
+    uint64_t    cold;                       // First accesses to a line.
+    uint64_t    dist[SD_DIST_BUCKETS];      // Distance d counted in bucket bits(d).
+    uint64_t    hits[SD_MAX_SET_BITS + 1][SD_MAX_ASSOC]; // By set count and stack position.
+} stackdist_t;
+
+extern bool stackdist_init(stackdist_t *sd, const unsigned min, const unsigned max,
+                           const unsigned assoc, const unsigned line);
+extern void stackdist_free(stackdist_t *sd);
+extern void stackdist_reset_stats(stackdist_t *sd);
+extern void stackdist_add_stats(stackdist_t *sum, const stackdist_t *sd);
+extern void stackdist_access(stackdist_t *sd, const uint64_t addr, const unsigned width);
+extern double stackdist_miss_rate(const stackdist_t *sd, const unsigned size, const unsigned assoc);
+#endif
@@ -0,0 +1,114 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * timing.h - Header file for timing models driven by retired instructions.
+ *
+ * A timing model consumes one trace_rec_t per retired instruction, whether
+ * the records come from a trace file or straight from the run loop, and
+ * keeps its own statistics. Models are created from a one-line
+ * configuration string of the form
+ *
+ *     <kind> key=value key=value ...
+ *
+ * where kind is one of
+ *
+ *     cache    size=32K assoc=8 line=64 side=d|i|u
+ *     bpred    kind=nottaken|bimodal|gshare bits=12
+ *     inorder  l1i=32K l1d=32K assoc=4 line=64 bpred=gshare bits=12
+ *              miss=20 mispredict=3 taken=1
+ *     sweep    min=1K max=1M assoc=4 line=64 side=d|i|u
+ *     tlb      itlb=64 dtlb=64 tlbassoc=4 stlb=1536 stlbassoc=12 stlbhit=7
+ *              pagesize=4K pwc=32 walk=20
+ *     ooo      fetch=4 issue=4 retire=4 rob=128 iq=32 prf=160 lsq=48 ports=2
+ *              alu=1 branch=1 load=3 store=1
+ *              l1i=32K l1d=32K assoc=4 line=64 bpred=gshare bits=12
+ *              miss=20 mispredict=3 taken=1
+ *
+ * A sweep (see stackdist.h) reports the miss rate of every LRU cache from
+ * min to max bytes, fully associative and 1 .. assoc way, in one pass.
+ * An ooo core (see ooo.h) is out of order: alu, branch, load and store
+ * are the latencies of each class of instruction, load being that of an
+ * L1D hit.
+ *
+ * Either core can put a DRAM (see dram.h) behind its L1s with
+ *
+ *     channels=1 banks=8 row=8K page=open|closed trcd=42 tcas=42 trp=42
+ *     tburst=8 wq=32
+ *
+ * An L1 miss then costs the miss latency plus the time to read the line
+ * from DRAM. channels=0, the default, leaves the DRAM out. Likewise
+ * tlb=1 makes either core translate its fetches and data accesses with
+ * the TLBs and page walks of a tlb model (see tlb.h), adding their cost.
+ *
+ * Sizes accept a K or M suffix. Omitted keys take the defaults shown.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _TIMING_H_
+#define _TIMING_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "trace.h"
+#include "cache.h"
+#include "bpred.h"
+#include "stackdist.h"
+#include "ooo.h"
+#include "dram.h"
+#include "tlb.h"
+
+typedef enum model_kind {
+    MODEL_CACHE,
+    MODEL_BPRED,
+    MODEL_INORDER,
+    MODEL_SWEEP,
+    MODEL_OOO,
+    MODEL_TLB,
+    MODEL_ERROR = -1
+} model_kind_t;
+
+typedef enum cache_side {
+    SIDE_I,
+    SIDE_D,
+    SIDE_U,
+    SIDE_ERROR = -1
+} cache_side_t;
+
+// A scalar in-order pipeline: one instruction per cycle plus penalties.
+typedef struct inorder {
+    cache_t     l1i;
+    cache_t     l1d;
+    bpred_t     bp;
+    dram_t      dram;           // Behind both L1s, if enabled.
+    tlb_t       tlb;            // In front of both L1s, if enabled.
+    unsigned    miss_lat;       // Cycles added by an L1 miss, before any DRAM latency.
+    unsigned    mispredict_pen; // Cycles added by a mispredicted B.cond.
+    unsigned    taken_pen;      // Fetch bubble after a correctly predicted taken transfer.
+    uint64_t    cycles;
+} inorder_t;
+
+typedef struct timing_model {
+    model_kind_t kind;
+    char        *config;    // The configuration line the model was built from.
+    uint64_t    instrs;     // Records consumed.
+    cache_side_t side;      // MODEL_CACHE: which accesses the cache sees.
+    cache_t     cache;      // MODEL_CACHE.
+    bpred_t     bp;         // MODEL_BPRED.
+    inorder_t   core;       // MODEL_INORDER.
+    stackdist_t sweep;      // MODEL_SWEEP; uses side too.
+    ooo_t       ooo;        // MODEL_OOO.
+    tlb_t       tlb;        // MODEL_TLB.
+} timing_model_t;
+
+extern bool timing_parse_size(const char *s, unsigned *out);
+extern timing_model_t *timing_model_create(const char *config);
+extern void timing_model_free(timing_model_t *m);
+extern void timing_model_consume(timing_model_t *m, const trace_rec_t *rec);
+extern void timing_model_reset_stats(timing_model_t *m);
+extern void timing_model_add_stats(timing_model_t *sum, const timing_model_t *m);
+extern double timing_model_metric(const timing_model_t *m, const char **name);
+extern void timing_model_report(const timing_model_t *m, FILE *out);
+#endif
@@ -0,0 +1,67 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * tlb.h - Header file for the guest TLB and page-walk timing model.
+ *
+ * ae runs guests without address translation, so the model supposes that
+ * every guest address is mapped by a four-level radix page table with a
+ * 4K granule, as on x86-64 and AArch64, using pages of a single size:
+ * PAGESIZE, or huge pages of 2M or 1G whose entries sit one or two levels
+ * up the tree.
+ *
+ * Fetches look up the ITLB and data accesses the DTLB. A miss in either
+ * looks up the shared second-level TLB (STLB) and a miss there walks the
+ * page table, one reference per level. The page-walk cache (PWC) keeps
+ * the upper-level entries recently used, so a walk starts from the
+ * deepest level whose entry it holds. The TLBs and the PWC are
+ * set-associative with LRU replacement.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _TLB_H_
+#define _TLB_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "cache.h"
+
+#define TLB_LEVELS 4        // Levels of the page table.
+#define TLB_BASE_BITS 12    // log2 of the granule.
+#define TLB_LEVEL_BITS 9    // Address bits translated by each level.
+
+typedef struct tlb_params {
+    unsigned    itlb;       // Entries in each TLB.
+    unsigned    dtlb;
+    unsigned    stlb;
+    unsigned    assoc;      // Ways in the ITLB and DTLB.
+    unsigned    stlb_assoc;
+    unsigned    stlb_hit;   // Cycles added by an L1 TLB miss that hits the STLB.
+    unsigned    page;       // Page size: 4K, 2M or 1G.
+    unsigned    pwc;        // Page-walk cache entries, fully associative; 0 for none.
+    unsigned    walk;       // Cycles per page-table reference.
+} tlb_params_t;
+
+typedef struct tlb {
+    tlb_params_t p;
+    unsigned    page_bits;  // log2 of the page size.
+    unsigned    leaf;       // Level of the leaf entries: 1 for 4K pages, 2 for 2M, 3 for 1G.
+    cache_t     itlb;       // Tags are page numbers, in lines of one byte.
+    cache_t     dtlb;
+    cache_t     stlb;
+    cache_t     pwc;        // Tags are an address prefix and a level.
+// Statistics; the TLBs and the PWC count their own lookups and misses.
+    uint64_t    walks;
+    uint64_t    walk_refs;  // Page-table references made by the walks.
+    uint64_t    cycles;     // Cycles added by translation.
+} tlb_t;
+
+static inline bool tlb_enabled(const tlb_t *t) {return 0 != t->p.page;}
+
+extern bool tlb_init(tlb_t *t, const tlb_params_t *p);
+extern void tlb_free(tlb_t *t);
+extern void tlb_reset_stats(tlb_t *t);
+extern void tlb_add_stats(tlb_t *sum, const tlb_t *t);
+extern unsigned tlb_translate(tlb_t *t, const uint64_t addr, const bool fetch);
+#endif
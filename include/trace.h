@@ -0,0 +1,115 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * trace.h - Header file for the binary instruction/memory trace.
+ *
+ * A trace is a file header followed by a sequence of blocks. Each block
+ * holds up to TRACE_BLOCK_RECS records, delta-encoded against the previous
+ * record of the same block and packed with variable-length integers, so
+ * that a sequential ALU instruction costs two to four bytes, depending on
+ * how many registers it names. Delta bases are reset
+ * at every block boundary, so each block can be decoded on its own.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _TRACE_H_
+#define _TRACE_H_
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "instr.h"
+
+#define TRACE_MAGIC "AETRACE2"
+#define TRACE_BLOCK_RECS 4096
+#define TRACE_IO_BUF_LEN (1 << 20)
+#define TRACE_NO_REG 0xFFU
+
+// Record header byte: low five bits hold the opcode, the rest are flags.
+// Opcodes from TR_OP_EXT up are written as TR_OP_EXT and a byte that
+// follows the header.
+#define TR_OP_MASK  0x1FU
+#define TR_OP_EXT   0x1EU
+#define TR_HAS_REGS 0x20U   // Registers were named; a register descriptor follows.
+#define TR_HAS_MEM  0x40U   // Memory was accessed; width and address follow.
+#define TR_NONSEQ   0x80U   // Next PC is not PC+4; target delta follows.
+
+// Register descriptor byte: the index of the register written (or
+// TR_REG_NONE) and flags for the source registers whose indices follow.
+#define TR_REG_MASK  0x3FU
+#define TR_REG_NONE  0x3FU
+#define TR_REG_SRC1  0x40U
+#define TR_REG_SRC2  0x80U
+
+// Memory descriptor byte.
+#define TR_MEM_LOG2W_MASK 0x3U
+#define TR_MEM_STORE      0x4U
+
+// One decoded trace record.
+typedef struct trace_rec {
+    uint64_t    pc;         // Address of the instruction.
+    uint64_t    next_pc;    // Address of the instruction executed after it.
+    uint64_t    mem_addr;   // Effective address, if mem_width != 0.
+    opcode_t    op;         // Opcode.
+    uint8_t     dst;        // Index of the register written, or TRACE_NO_REG.
+    uint8_t     src1;       // Indices of the registers read, or TRACE_NO_REG.
+    uint8_t     src2;       // XZR is never a source; SP is register 31.
+    uint8_t     mem_width;  // Bytes accessed (0, 1, 2, 4 or 8).
+    bool        is_store;   // True if the memory access is a write.
+    bool        taken;      // True if control did not fall through to PC+4.
+} trace_rec_t;
+
+// File header.
+typedef struct trace_file_hdr {
+    char        magic[8];
+    uint64_t    entry;      // Entry point of the traced program.
+} trace_file_hdr_t;
+
+// Block header. The packed records follow immediately.
+typedef struct trace_block_hdr {
+    uint32_t    nrecs;      // Number of records in the block.
+    uint32_t    nbytes;     // Number of bytes of packed records.
+    uint64_t    first_pc;   // PC of the first record.
+} trace_block_hdr_t;
+
+// Writer statistics.
+typedef struct trace_stats {
+    uint64_t    num_recs;   // Records written.
+    uint64_t    num_bytes;  // Bytes written, including headers.
+    double      secs;       // Host time spent encoding and writing.
+} trace_stats_t;
+
+// A trace file mapped read-only into memory. Any number of readers, possibly
+// on different threads, can walk the same mapping.
+typedef struct trace_map {
+    const uint8_t *base;
+    size_t      len;
+    uint64_t    entry;      // Entry point of the traced program.
+} trace_map_t;
+
+// Reader state: a cursor over a mapped trace.
+typedef struct trace_reader {
+    const trace_map_t *map;
+    size_t      off;        // Offset of the next block header.
+    uint32_t    left;       // Records remaining in the current block.
+    const uint8_t *cur;     // Decode position within the current block.
+    uint64_t    pc;         // Delta base: PC of the next record.
+    uint64_t    addr;       // Delta base: last memory address.
+} trace_reader_t;
+
+// Writer.
+extern void trace_fill(trace_rec_t *rec, const instr_t *insn, const uint64_t pc, const uint64_t next_pc);
+extern bool trace_open(const char *path, const uint64_t entry);
+extern void trace_instr(const instr_t *insn, const uint64_t pc, const uint64_t next_pc);
+extern void trace_write(const trace_rec_t *rec);
+extern void trace_close(trace_stats_t *stats);
+extern bool trace_is_open(void);
+
+// Reader.
+extern bool trace_map_open(trace_map_t *m, const char *path);
+extern void trace_map_close(trace_map_t *m);
+extern void trace_reader_init(trace_reader_t *r, const trace_map_t *m);
+extern bool trace_next(trace_reader_t *r, trace_rec_t *rec);
+#endif
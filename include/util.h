@@ -0,0 +1,28 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * util.h - Small helpers shared by the emulator, its models and its tools.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _UTIL_H_
+#define _UTIL_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
+
+static inline bool is_pow2(const unsigned x) {return x && !(x & (x - 1));}
+
+// n / d, or 0 if d is.
+static inline double ratio(const uint64_t n, const uint64_t d) {return d ? (double) n / d : 0.0;}
+
+// Seconds on the host's monotonic clock.
+static inline double now_secs(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+#endif
@@ -11,16 +11,11 @@
 
 #include "archsim.h"
 
-machine_t guest;
-opcode_t itable[2<<11];
-FILE *infile, *outfile, *errfile;
-char *ae_prompt;
-
 int main(int argc, char* argv[]) {
-    // handle_args(argc, argv);
+    handle_args(argc, argv);
     init();
     
-    uint64_t entry = loadElf(argv[1]);
+    uint64_t entry = loadElf(elf_file);
     int ret = runElf(entry);
     
     finalize();
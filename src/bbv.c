@@ -0,0 +1,105 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * bbv.c - Collection of basic-block vectors, one per interval.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include "archsim.h"
+
+#define BBV_HASHSIZE 4096
+
+typedef struct bbv_block {
+    uint64_t    pc;         // Entry PC.
+    unsigned    id;         // From 1, in order of first execution.
+    uint64_t    count;      // Instructions run in the block this interval.
+    struct bbv_block *next;
+} bbv_block_t;
+
+static char printbuf[BUF_LEN];
+static FILE *fp;
+static uint64_t interval;
+static uint64_t used;           // Instructions counted this interval.
+static uint64_t num_intervals;
+static unsigned num_blocks;
+static bbv_block_t *blocks[BBV_HASHSIZE];
+static bbv_block_t *last;       // Most recently counted block.
+static bbv_block_t **touched;   // Blocks with a nonzero count this interval.
+static unsigned num_touched, cap_touched;
+
+static inline unsigned block_hash(const uint64_t pc) {return (pc >> 2) % BBV_HASHSIZE;}
+
+static bbv_block_t *get_block(const uint64_t pc) {
+    unsigned h = block_hash(pc);
+    for (bbv_block_t *b = blocks[h]; b; b = b->next)
+        if (b->pc == pc) return b;
+    bbv_block_t *b = calloc(1, sizeof(bbv_block_t));
+    b->pc = pc;
+    b->id = ++num_blocks;
+    b->next = blocks[h];
+    blocks[h] = b;
+    return b;
+}
+
+bool bbv_open(const char *path, const uint64_t n) {
+    if (0 == n || NULL == (fp = fopen(path, "w"))) return false;
+    interval = n;
+    return true;
+}
+
+/*
+ * Instructions left in the current interval, so that the run loop can
+ * keep fused groups from straddling two.
+ */
+
+uint64_t bbv_room(void) {
+    return interval - used;
+}
+
+static void end_interval(void) {
+    fputc('T', fp);
+    for (unsigned i = 0; i < num_touched; i++) {
+        fprintf(fp, ":%u:%lu ", touched[i]->id, touched[i]->count);
+        touched[i]->count = 0;
+    }
+    fputc('\n', fp);
+    num_touched = 0;
+    used = 0;
+    num_intervals++;
+}
+
+/*
+ * Count n instructions, none past the end of the interval, as run in the
+ * block entered at head.
+ */
+
+void bbv_count(const uint64_t head, const unsigned n) {
+    bbv_block_t *b = last;
+    if (NULL == b || b->pc != head) last = b = get_block(head);
+    if (0 == b->count) {
+        if (num_touched == cap_touched) {
+            cap_touched = cap_touched ? 2 * cap_touched : 256;
+            touched = realloc(touched, cap_touched * sizeof(bbv_block_t *));
+        }
+        touched[num_touched++] = b;
+    }
+    b->count += n;
+    if ((used += n) == interval) end_interval();
+}
+
+/*
+ * End of run: write the last, partial interval. Safe to call more than
+ * once, so that it can also be registered with atexit for runs ending in
+ * HLT.
+ */
+
+void bbv_close(void) {
+    if (NULL == fp) return;
+    if (num_touched) end_interval();
+    fclose(fp);
+    fp = NULL;
+    sprintf(printbuf, "BBV: %lu intervals of %lu instrs, %u blocks", num_intervals, interval, num_blocks);
+    logging(LOG_INFO, printbuf);
+}
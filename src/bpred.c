@@ -0,0 +1,76 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * bpred.c - Conditional branch predictor models.
+ *
+ * Only the direction of B.cond is predicted; targets of B, BL and RET are
+ * assumed to be known in time.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "bpred.h"
+
+#define MAX_BPRED_BITS 24
+
+static char *bpred_names[] = {"nottaken", "bimodal", "gshare"};
+
+bpred_kind_t bpred_kind(const char *name) {
+    for (int i = BP_NOT_TAKEN; i <= BP_GSHARE; i++)
+        if (0 == strcmp(name, bpred_names[i])) return (bpred_kind_t) i;
+    return BP_ERROR;
+}
+
+bool bpred_init(bpred_t *bp, const bpred_kind_t kind, const unsigned bits) {
+    memset(bp, 0, sizeof(*bp));
+    if (BP_ERROR == kind || bits > MAX_BPRED_BITS) return false;
+    bp->kind = kind;
+    bp->bits = bits;
+    if (BP_BIMODAL == kind || BP_GSHARE == kind) {
+        bp->table = malloc(1UL << bits);
+        memset(bp->table, 1, 1UL << bits); // Weakly not taken.
+    }
+    return true;
+}
+
+void bpred_free(bpred_t *bp) {
+    free(bp->table);
+    memset(bp, 0, sizeof(*bp));
+}
+
+void bpred_reset_stats(bpred_t *bp) {
+    bp->lookups = bp->mispredicts = 0;
+}
+
+/*
+ * Predict the conditional branch at pc, then train on its actual outcome.
+ * Returns true if the prediction was correct.
+ */
+
+bool bpred_update(bpred_t *bp, const uint64_t pc, const bool taken) {
+    bool pred;
+    uint64_t idx = 0;
+    switch (bp->kind) {
+        case BP_NOT_TAKEN: pred = false; break;
+        case BP_BIMODAL:
+            idx = (pc >> 2) & ((1UL << bp->bits) - 1);
+            pred = bp->table[idx] >= 2;
+            break;
+        case BP_GSHARE:
+            idx = ((pc >> 2) ^ bp->ghist) & ((1UL << bp->bits) - 1);
+            pred = bp->table[idx] >= 2;
+            break;
+        default: pred = false; break;
+    }
+    if (bp->table) {
+        if (taken && bp->table[idx] < 3) bp->table[idx]++;
+        if (!taken && bp->table[idx] > 0) bp->table[idx]--;
+    }
+    bp->ghist = (bp->ghist << 1) | taken;
+    bp->lookups++;
+    if (pred != taken) bp->mispredicts++;
+    return pred == taken;
+}
@@ -0,0 +1,87 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * cache.c - Set-associative cache timing model.
+ *
+ * The model tracks tags only; data always comes from the functional
+ * memory in mem.c.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "cache.h"
+#include "util.h"
+
+/*
+ * Set up a cache of the given geometry. Returns false if the geometry is
+ * not realizable (sizes must be powers of two and divide evenly).
+ */
+
+bool cache_init(cache_t *c, const unsigned size, const unsigned assoc, const unsigned line) {
+    memset(c, 0, sizeof(*c));
+    if (!is_pow2(line) || 0 == assoc || size % (assoc * line)) return false;
+    c->size = size;
+    c->assoc = assoc;
+    c->line = line;
+    c->num_sets = size / (assoc * line);
+    if (!is_pow2(c->num_sets)) return false;
+    while ((1U << c->line_bits) < line) c->line_bits++;
+    c->tags = calloc(c->num_sets * assoc, sizeof(uint64_t));
+    c->stamps = calloc(c->num_sets * assoc, sizeof(uint64_t));
+    c->dirty = calloc(c->num_sets * assoc, sizeof(bool));
+    return true;
+}
+
+void cache_free(cache_t *c) {
+    free(c->tags);
+    free(c->stamps);
+    free(c->dirty);
+    memset(c, 0, sizeof(*c));
+}
+
+void cache_reset_stats(cache_t *c) {
+    c->accesses = c->misses = c->writebacks = 0;
+}
+
+static bool cache_access_line(cache_t *c, const uint64_t lnum, const bool is_write) {
+    unsigned set = lnum & (c->num_sets - 1);
+    uint64_t *tags = c->tags + set * c->assoc;
+    uint64_t *stamps = c->stamps + set * c->assoc;
+    bool *dirty = c->dirty + set * c->assoc;
+    unsigned victim = 0;
+    c->accesses++;
+    c->tick++;
+    for (unsigned w = 0; w < c->assoc; w++) {
+        if (stamps[w] && tags[w] == lnum) {
+            stamps[w] = c->tick;
+            dirty[w] |= is_write;
+            return true;
+        }
+        if (stamps[w] < stamps[victim]) victim = w;
+    }
+    c->misses++;
+    if (stamps[victim] && dirty[victim]) {
+        c->writebacks++;
+        c->victim = tags[victim] << c->line_bits;
+    }
+    tags[victim] = lnum;
+    stamps[victim] = c->tick;
+    dirty[victim] = is_write;
+    return false;
+}
+
+/*
+ * Access width bytes at addr. An access that straddles a line boundary
+ * touches both lines and hits only if both do.
+ */
+
+bool cache_access(cache_t *c, const uint64_t addr, const unsigned width, const bool is_write) {
+    uint64_t first = addr >> c->line_bits;
+    uint64_t last = (addr + (width ? width - 1 : 0)) >> c->line_bits;
+    bool hit = cache_access_line(c, first, is_write);
+    if (last != first) hit &= cache_access_line(c, last, is_write);
+    return hit;
+}
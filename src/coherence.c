@@ -0,0 +1,329 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * coherence.c - Snooping MESI/MOESI model of the cores' data caches.
+ *
+ * A snoop looks the line up in every other core's cache. A line that
+ * another core's write invalidated keeps its tag, marked lost, so that the
+ * next miss on it can be told from a capacity or conflict miss; a fill
+ * takes an empty way first and a lost one next, before evicting anything.
+ * Events are charged to lines and PCs in hash tables that hold only the
+ * lines and PCs that have had one.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "coherence.h"
+#include "timing.h"
+#include "util.h"
+
+static char *protocol_names[] = {"mesi", "moesi"};
+
+static coh_protocol_t coh_protocol(const char *name) {
+    for (int i = COH_MESI; i <= COH_MOESI; i++)
+        if (0 == strcmp(name, protocol_names[i])) return (coh_protocol_t) i;
+    return COH_ERROR;
+}
+
+/*
+ * Build a model of num_cores caches from a configuration line (see
+ * coherence.h). Returns NULL if the line does not describe a valid model.
+ */
+
+coh_t *coh_create(const char *config, const unsigned num_cores) {
+    coh_params_t p = {.protocol = COH_MESI, .size = 32 << 10, .assoc = 8, .line = 64, .top = 10};
+    char *buf = strdup(config), *save, *tok;
+    bool ok = NULL != (tok = strtok_r(buf, " \t\n", &save)) && COH_ERROR != (p.protocol = coh_protocol(tok));
+    while (ok && NULL != (tok = strtok_r(NULL, " \t\n", &save))) {
+        char *val = strchr(tok, '=');
+        if (NULL == val) {ok = false; break;}
+        *val++ = '\0';
+        if (0 == strcmp(tok, "size")) ok = timing_parse_size(val, &p.size);
+        else if (0 == strcmp(tok, "assoc")) ok = timing_parse_size(val, &p.assoc);
+        else if (0 == strcmp(tok, "line")) ok = timing_parse_size(val, &p.line);
+        else if (0 == strcmp(tok, "top")) ok = timing_parse_size(val, &p.top);
+        else ok = false;
+    }
+    free(buf);
+    if (!ok || 0 == num_cores || !is_pow2(p.line) || p.line > COH_MAX_LINE) return NULL;
+    if (0 == p.assoc || p.size % (p.assoc * p.line) || !is_pow2(p.size / (p.assoc * p.line))) return NULL;
+
+    coh_t *c = calloc(1, sizeof(coh_t));
+    c->p = p;
+    c->config = strdup(config);
+    c->config[strcspn(c->config, "\n")] = '\0';
+    c->num_cores = num_cores;
+    c->num_sets = p.size / (p.assoc * p.line);
+    while ((1U << c->line_bits) < p.line) c->line_bits++;
+    c->lines = calloc((size_t) num_cores * c->num_sets * p.assoc, sizeof(coh_line_t));
+    c->cores = calloc(num_cores, sizeof(coh_counts_t));
+    return c;
+}
+
+void coh_free(coh_t *c) {
+    free(c->config);
+    free(c->lines);
+    free(c->cores);
+    free(c->by_line.slots);
+    free(c->by_pc.slots);
+    free(c);
+}
+
+/*
+ * Sites.
+ */
+
+// The slot for key, or the free one where it would go. The table has room.
+static coh_site_t *slot(const coh_sites_t *t, const uint64_t key) {
+    size_t i = (key * 0x9E3779B97F4A7C15ULL) >> 32 & (t->cap - 1);
+    while (t->slots[i].key && t->slots[i].key != key + 1) i = (i + 1) & (t->cap - 1);
+    return t->slots + i;
+}
+
+static coh_site_t *site(coh_sites_t *t, const uint64_t key) {
+    if (2 * (t->used + 1) > t->cap) {
+        coh_sites_t old = *t;
+        t->cap = old.cap ? 2 * old.cap : 256;
+        t->slots = calloc(t->cap, sizeof(coh_site_t));
+        for (size_t i = 0; i < old.cap; i++)
+            if (old.slots[i].key) *slot(t, old.slots[i].key - 1) = old.slots[i];
+        free(old.slots);
+    }
+    coh_site_t *s = slot(t, key);
+    if (0 == s->key) {
+        s->key = key + 1;
+        t->used++;
+    }
+    return s;
+}
+
+/*
+ * Caches.
+ */
+
+static inline coh_line_t *set_of(const coh_t *c, const unsigned core, const uint64_t lnum) {
+    return c->lines + ((size_t) core * c->num_sets + (lnum & (c->num_sets - 1))) * c->p.assoc;
+}
+
+static inline bool holds(const coh_line_t *l) {return NULL != l && COH_I != l->state;}
+
+// The way of core's cache with lnum in it, held or lost, or NULL.
+static coh_line_t *lookup(const coh_t *c, const unsigned core, const uint64_t lnum) {
+    coh_line_t *set = set_of(c, core, lnum);
+    for (unsigned w = 0; w < c->p.assoc; w++)
+        if (set[w].lnum == lnum && (COH_I != set[w].state || set[w].lost)) return set + w;
+    return NULL;
+}
+
+// The way to fill with lnum: an empty one, else the least recently used
+// lost one, else the least recently used.
+static coh_line_t *victim(const coh_t *c, const unsigned core, const uint64_t lnum) {
+    coh_line_t *set = set_of(c, core, lnum), *v = set;
+    for (unsigned w = 0; w < c->p.assoc; w++) {
+        coh_line_t *l = set + w;
+        if (COH_I == l->state && !l->lost) return l;
+        bool l_lost = COH_I == l->state, v_lost = COH_I == v->state;
+        if (l_lost > v_lost || (l_lost == v_lost && l->stamp < v->stamp)) v = l;
+    }
+    return v;
+}
+
+// Bytes of lnum written by the cores other than core that hold it.
+static uint64_t written_elsewhere(const coh_t *c, const unsigned core, const uint64_t lnum) {
+    uint64_t written = 0;
+    for (unsigned k = 0; k < c->num_cores; k++) {
+        coh_line_t *l = k == core ? NULL : lookup(c, k, lnum);
+        if (holds(l)) written |= l->written;
+    }
+    return written;
+}
+
+/*
+ * A write by core at pc to the bytes mask of lnum: invalidate the other
+ * copies. Returns true if one of them was dirty, and so supplies the data.
+ */
+
+static bool invalidate(coh_t *c, const unsigned core, const uint64_t pc, const uint64_t lnum,
+                       const uint64_t mask) {
+    bool dirty = false;
+    unsigned n = 0;
+    for (unsigned k = 0; k < c->num_cores; k++) {
+        coh_line_t *l = k == core ? NULL : lookup(c, k, lnum);
+        if (!holds(l)) continue;
+        dirty |= COH_M == l->state || COH_O == l->state;
+        l->state = COH_I;
+        l->lost = true;
+        l->written = mask;
+        n++;
+    }
+    if (n) {
+        c->cores[core].invalidations += n;
+        site(&c->by_line, lnum)->invalidations += n;
+        site(&c->by_pc, pc)->invalidations += n;
+    }
+    return dirty;
+}
+
+/*
+ * A read by core of the bytes of lnum another cache may hold: snoop the
+ * others. Returns true if any holds it, and sets *dirty if a dirty copy
+ * supplies the data.
+ */
+
+static bool snoop_read(coh_t *c, const unsigned core, const uint64_t lnum, bool *dirty) {
+    bool shared = false;
+    for (unsigned k = 0; k < c->num_cores; k++) {
+        coh_line_t *l = k == core ? NULL : lookup(c, k, lnum);
+        if (!holds(l)) continue;
+        shared = true;
+        switch (l->state) {
+            case COH_M:
+                *dirty = true;
+                if (COH_MOESI == c->p.protocol) l->state = COH_O;
+                else {
+                    l->state = COH_S;
+                    c->cores[k].writebacks++;
+                }
+                break;
+            case COH_O:
+                *dirty = true;
+                break;
+            case COH_E:
+                l->state = COH_S;
+                break;
+            default: break;
+        }
+    }
+    return shared;
+}
+
+static void access_line(coh_t *c, const unsigned core, const uint64_t pc, const uint64_t lnum,
+                        const uint64_t mask, const bool store) {
+    coh_counts_t *cc = c->cores + core;
+    coh_line_t *l = lookup(c, core, lnum);
+    c->now++;
+    cc->accesses++;
+    if (holds(l)) {
+        l->stamp = c->now;
+        if (!store) return;
+        switch (l->state) {
+            case COH_S: case COH_O:
+                cc->upgrades++;
+                invalidate(c, core, pc, lnum, mask);
+                break;
+            case COH_E:
+                l->written = 0;
+                break;
+            default: break;
+        }
+        l->state = COH_M;
+        l->written |= mask;
+        return;
+    }
+
+    cc->misses++;
+    if (NULL != l) {
+        coh_site_t *by_line = site(&c->by_line, lnum), *by_pc = site(&c->by_pc, pc);
+        cc->coherence_misses++;
+        by_line->coherence_misses++;
+        by_pc->coherence_misses++;
+        if (!((l->written | written_elsewhere(c, core, lnum)) & mask)) {
+            cc->false_sharing++;
+            by_line->false_sharing++;
+            by_pc->false_sharing++;
+        }
+    } else {
+        l = victim(c, core, lnum);
+        if (COH_M == l->state || COH_O == l->state) cc->writebacks++;
+    }
+    bool dirty = false, shared = false;
+    if (store) dirty = invalidate(c, core, pc, lnum, mask);
+    else shared = snoop_read(c, core, lnum, &dirty);
+    if (dirty) cc->transfers++;
+    l->lnum = lnum;
+    l->stamp = c->now;
+    l->lost = false;
+    l->state = store ? COH_M : shared ? COH_S : COH_E;
+    l->written = store ? mask : 0;
+}
+
+/*
+ * An access by core at pc to width bytes at addr, which may straddle two
+ * lines.
+ */
+
+void coh_access(coh_t *c, const unsigned core, const uint64_t pc,
+                const uint64_t addr, const unsigned width, const bool store) {
+    uint64_t end = addr + width;
+    for (uint64_t a = addr; a < end; ) {
+        uint64_t lnum = a >> c->line_bits, next = (lnum + 1) << c->line_bits;
+        unsigned off = a & (c->p.line - 1), n = (next < end ? next : end) - a;
+        uint64_t mask = (64 == n ? ~0ULL : (1ULL << n) - 1) << off;
+        access_line(c, core, pc, lnum, mask, store);
+        a += n;
+    }
+}
+
+/*
+ * Reporting.
+ */
+
+static int by_events(const void *a, const void *b) {
+    const coh_site_t *x = *(const coh_site_t *const *) a, *y = *(const coh_site_t *const *) b;
+    uint64_t ex = x->invalidations + x->coherence_misses, ey = y->invalidations + y->coherence_misses;
+    if (ex != ey) return ex < ey ? 1 : -1;
+    return x->key < y->key ? -1 : x->key > y->key;
+}
+
+static void report_counts(const coh_counts_t *k, FILE *out) {
+    fprintf(out, "\taccesses=%lu\tmisses=%lu\tmiss_rate=%.6f\tcoherence_misses=%lu\tfalse_sharing=%lu",
+            k->accesses, k->misses, ratio(k->misses, k->accesses), k->coherence_misses, k->false_sharing);
+    fprintf(out, "\tupgrades=%lu\tinvalidations=%lu\ttransfers=%lu\twritebacks=%lu\n",
+            k->upgrades, k->invalidations, k->transfers, k->writebacks);
+}
+
+// The top sites of t, most events first, with their keys shifted left by shift.
+static void report_sites(const coh_t *c, const coh_sites_t *t, const char *what,
+                         const unsigned shift, FILE *out) {
+    const coh_site_t **top = malloc((t->used + 1) * sizeof(coh_site_t *));
+    size_t n = 0;
+    for (size_t i = 0; i < t->cap; i++)
+        if (t->slots[i].key) top[n++] = t->slots + i;
+    qsort(top, n, sizeof(coh_site_t *), by_events);
+    for (size_t i = 0; i < n && i < c->p.top; i++)
+        fprintf(out, "%s=0x%lx\tinvalidations=%lu\tcoherence_misses=%lu\tfalse_sharing=%lu\n", what,
+                (top[i]->key - 1) << shift, top[i]->invalidations, top[i]->coherence_misses,
+                top[i]->false_sharing);
+    free(top);
+}
+
+/*
+ * Report the totals, then each core's counts, then the top lines and PCs,
+ * one tab-separated line apiece.
+ */
+
+void coh_report(const coh_t *c, FILE *out) {
+    coh_counts_t sum = {0};
+    for (unsigned k = 0; k < c->num_cores; k++) {
+        const coh_counts_t *e = c->cores + k;
+        sum.accesses += e->accesses;
+        sum.misses += e->misses;
+        sum.coherence_misses += e->coherence_misses;
+        sum.false_sharing += e->false_sharing;
+        sum.upgrades += e->upgrades;
+        sum.invalidations += e->invalidations;
+        sum.transfers += e->transfers;
+        sum.writebacks += e->writebacks;
+    }
+    fprintf(out, "config=\"%s\"\tcores=%u", c->config, c->num_cores);
+    report_counts(&sum, out);
+    for (unsigned k = 0; k < c->num_cores; k++) {
+        fprintf(out, "core=%u", k);
+        report_counts(c->cores + k, out);
+    }
+    report_sites(c, &c->by_line, "line", c->line_bits, out);
+    report_sites(c, &c->by_pc, "pc", 0, out);
+}
@@ -0,0 +1,99 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * detail.c - Timing models driven straight from the run loop, after an
+ * optional fast-forward.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include "archsim.h"
+
+extern __thread machine_t guest;
+
+static char printbuf[BUF_LEN];
+static timing_model_t *models[DETAIL_MAX_MODELS];
+static unsigned num_models;
+static uint64_t warmup_left;    // Detailed instructions still to warm up on.
+static bool finished;
+
+bool detail_add_model(const char *config) {
+    if (DETAIL_MAX_MODELS == num_models) return false;
+    timing_model_t *m = timing_model_create(config);
+    if (NULL == m) return false;
+    models[num_models++] = m;
+    return true;
+}
+
+unsigned detail_num_models(void) {
+    return num_models;
+}
+
+timing_model_t *detail_model(const unsigned i) {
+    return models[i];
+}
+
+/*
+ * The PC named by spec: a number, or else a symbol of the executable.
+ * Returns 0 if there is no such symbol.
+ */
+
+uint64_t detail_stop_pc(const char *spec) {
+    char *end;
+    uint64_t pc = strtoull(spec, &end, 0);
+    if ('\0' == *spec || '\0' != *end) pc = elf_symbol(elf_file, spec);
+    return pc;
+}
+
+/*
+ * Called when fast-forwarding ends, before the first detailed instruction.
+ */
+
+void detail_begin(const uint64_t warmup) {
+    sprintf(printbuf, "Detailed simulation from instr %lu, PC 0x%lx",
+            num_instr, guest.proc->regs[R_PC].xval);
+    logging(LOG_INFO, printbuf);
+    for (unsigned i = 0; i < num_models; i++)
+        timing_model_reset_stats(models[i]);
+    warmup_left = warmup;
+}
+
+// True until the warm-up instructions have all been retired.
+bool detail_warming(void) {
+    return 0 != warmup_left;
+}
+
+/*
+ * Called for each instruction retired in detail, after its update-PC stage.
+ */
+
+void detail_retire(const instr_t *insn, const uint64_t pc, const uint64_t next_pc) {
+    trace_rec_t rec;
+    if (!roi_active || 0 == num_models) return;
+    trace_fill(&rec, insn, pc, next_pc);
+    for (unsigned i = 0; i < num_models; i++)
+        timing_model_consume(models[i], &rec);
+    if (warmup_left && 0 == --warmup_left) {
+        for (unsigned i = 0; i < num_models; i++)
+            timing_model_reset_stats(models[i]);
+        sprintf(printbuf, "Warm-up done at instr %lu", num_instr + 1);
+        logging(LOG_INFO, printbuf);
+    }
+}
+
+/*
+ * End of run: report each model, one line apiece, on errfile so that the
+ * guest's output is left alone. Safe to call more than once, so that it
+ * can also be registered with atexit for runs ending in HLT.
+ */
+
+void detail_finish(void) {
+    if (finished) return;
+    finished = true;
+    for (unsigned i = 0; i < num_models; i++) {
+        timing_model_report(models[i], errfile);
+        timing_model_free(models[i]);
+    }
+    num_models = 0;
+}
@@ -0,0 +1,190 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * dram.c - Main-memory DRAM timing model.
+ *
+ * A bank takes its next column command tBURST cycles after the last, and
+ * under the closed-page policy its next activate tRP cycles after its
+ * data has gone out. Refresh and the write-to-read turnaround are not
+ * modeled.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "dram.h"
+#include "util.h"
+
+static char *policy_names[] = {"open", "closed"};
+
+dram_policy_t dram_policy(const char *name) {
+    for (int i = DRAM_OPEN; i <= DRAM_CLOSED; i++)
+        if (0 == strcmp(name, policy_names[i])) return (dram_policy_t) i;
+    return DRAM_ERROR;
+}
+
+/*
+ * Set up a DRAM serving lines of the given size. Returns false if the
+ * geometry is not realizable (a row must hold a whole number of lines).
+ */
+
+bool dram_init(dram_t *d, const dram_params_t *p, const unsigned line) {
+    memset(d, 0, sizeof(*d));
+    if (0 == p->channels || 0 == p->banks || 0 == p->wq || DRAM_ERROR == p->policy) return false;
+    if (!is_pow2(line) || p->row < line || p->row % line) return false;
+    d->p = *p;
+    while ((1U << d->line_bits) < line) d->line_bits++;
+    d->cols = p->row / line;
+    d->banks = calloc((size_t) p->channels * p->banks, sizeof(dram_bank_t));
+    d->bus_free = calloc(p->channels, sizeof(uint64_t));
+    d->wq = calloc((size_t) p->channels * p->wq, sizeof(uint64_t));
+    d->wq_n = calloc(p->channels, sizeof(unsigned));
+    return true;
+}
+
+void dram_free(dram_t *d) {
+    free(d->banks);
+    free(d->bus_free);
+    free(d->wq);
+    free(d->wq_n);
+    memset(d, 0, sizeof(*d));
+}
+
+void dram_reset_stats(dram_t *d) {
+    d->reads = d->writes = d->wq_hits = 0;
+    d->row_hits = d->row_empty = d->row_conflicts = 0;
+    d->read_cycles = 0;
+}
+
+void dram_add_stats(dram_t *sum, const dram_t *d) {
+    sum->reads += d->reads;
+    sum->writes += d->writes;
+    sum->wq_hits += d->wq_hits;
+    sum->row_hits += d->row_hits;
+    sum->row_empty += d->row_empty;
+    sum->row_conflicts += d->row_conflicts;
+    sum->read_cycles += d->read_cycles;
+}
+
+static inline unsigned channel_of(const dram_t *d, const uint64_t lnum) {
+    return (lnum / d->cols) % d->p.channels;
+}
+
+static inline dram_bank_t *bank_of(const dram_t *d, const uint64_t lnum) {
+    uint64_t r = lnum / d->cols / d->p.channels;
+    return d->banks + channel_of(d, lnum) * d->p.banks + r % d->p.banks;
+}
+
+static inline uint64_t row_of(const dram_t *d, const uint64_t lnum) {
+    return lnum / d->cols / d->p.channels / d->p.banks;
+}
+
+static inline uint64_t max64(const uint64_t a, const uint64_t b) {return a > b ? a : b;}
+
+/*
+ * Carry out one access to line lnum, starting no sooner than t. Returns
+ * the cycle its data has been transferred.
+ */
+
+static uint64_t access_line(dram_t *d, const uint64_t lnum, const uint64_t t) {
+    dram_bank_t *b = bank_of(d, lnum);
+    uint64_t row = row_of(d, lnum) + 1;
+    uint64_t start = max64(t, b->ready), col;
+    if (b->open_row == row) {
+        col = start;
+        d->row_hits++;
+    } else if (0 == b->open_row) {
+        col = start + d->p.trcd;
+        d->row_empty++;
+    } else {
+        col = start + d->p.trp + d->p.trcd;
+        d->row_conflicts++;
+    }
+    uint64_t *bus = d->bus_free + channel_of(d, lnum);
+    uint64_t end = max64(col + d->p.tcas, *bus) + d->p.tburst;
+    *bus = end;
+    switch (d->p.policy) {
+        case DRAM_OPEN:
+            b->open_row = row;
+            b->ready = col + d->p.tburst;
+            break;
+        case DRAM_CLOSED:
+            b->open_row = 0;
+            b->ready = end + d->p.trp;
+            break;
+        default: break;
+    }
+    return end;
+}
+
+/*
+ * Write queued lines back to half the queue's size, row hits first, then
+ * the oldest.
+ */
+
+static void drain_writes(dram_t *d, const unsigned ch, const uint64_t t) {
+    uint64_t *q = d->wq + (size_t) ch * d->p.wq;
+    unsigned *n = d->wq_n + ch;
+    while (*n > d->p.wq / 2) {
+        unsigned pick = 0;
+        for (unsigned i = 0; i < *n; i++)
+            if (bank_of(d, q[i])->open_row == row_of(d, q[i]) + 1) {
+                pick = i;
+                break;
+            }
+        access_line(d, q[pick], t);
+        memmove(q + pick, q + pick + 1, (*n - pick - 1) * sizeof(uint64_t));
+        (*n)--;
+    }
+}
+
+/*
+ * Read the line holding addr, asked for at cycle t. Returns the cycles
+ * until its data has arrived.
+ */
+
+uint64_t dram_read(dram_t *d, const uint64_t addr, const uint64_t t) {
+    uint64_t lnum = addr >> d->line_bits;
+    unsigned ch = channel_of(d, lnum);
+    const uint64_t *q = d->wq + (size_t) ch * d->p.wq;
+    d->reads++;
+    for (unsigned i = 0; i < d->wq_n[ch]; i++)
+        if (q[i] == lnum) {
+            d->wq_hits++;
+            return 0;
+        }
+    uint64_t lat = access_line(d, lnum, t) - t;
+    d->read_cycles += lat;
+    return lat;
+}
+
+/*
+ * Queue the line holding addr to be written back, at cycle t.
+ */
+
+void dram_write(dram_t *d, const uint64_t addr, const uint64_t t) {
+    uint64_t lnum = addr >> d->line_bits;
+    unsigned ch = channel_of(d, lnum);
+    uint64_t *q = d->wq + (size_t) ch * d->p.wq;
+    d->writes++;
+    for (unsigned i = 0; i < d->wq_n[ch]; i++)
+        if (q[i] == lnum) return;
+    q[d->wq_n[ch]++] = lnum;
+    if (d->wq_n[ch] == d->p.wq) drain_writes(d, ch, t);
+}
+
+/*
+ * Cache c has just missed on addr at cycle t. Write back the dirty line
+ * it evicted, if its writeback count has moved on from writebacks, and
+ * return the cycles until the line holding addr has been read: 0 if
+ * there is no DRAM model.
+ */
+
+uint64_t dram_fill(dram_t *d, const cache_t *c, const uint64_t writebacks,
+                   const uint64_t addr, const uint64_t t) {
+    if (!dram_enabled(d)) return 0;
+    if (c->writebacks != writebacks) dram_write(d, c->victim, t);
+    return dram_read(d, addr, t);
+}
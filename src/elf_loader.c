@@ -11,6 +11,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include <assert.h>
 #include <fcntl.h>
 #include <sys/mman.h>
@@ -70,3 +72,36 @@ uint64_t loadElf(const char *fileName) {
 
     return entry;
 }
+
+/*
+ * Address of the symbol name in an ELF executable, or 0 if it has none.
+ */
+
+uint64_t elf_symbol(const char *fileName, const char *name) {
+    uint64_t addr = 0;
+    struct stat statBuffer;
+    int fd = open(fileName, O_RDONLY);
+    if (fd < 0) return 0;
+    if (fstat(fd, &statBuffer) != 0) {
+        close(fd);
+        return 0;
+    }
+    uintptr_t ptr = (uintptr_t) mmap(0, statBuffer.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if ((void *)ptr == MAP_FAILED) return 0;
+
+    Elf64_Ehdr *header = (Elf64_Ehdr *) ptr;
+    Elf64_Shdr *sh = (Elf64_Shdr *) (ptr + header->e_shoff);
+    for (unsigned i = 0; header->e_shoff && i < header->e_shnum && !addr; i++) {
+        if (SHT_SYMTAB != sh[i].sh_type) continue;
+        Elf64_Sym *syms = (Elf64_Sym *) (ptr + sh[i].sh_offset);
+        const char *strtab = (const char *) (ptr + sh[sh[i].sh_link].sh_offset);
+        for (unsigned j = 0; j < sh[i].sh_size / sizeof(Elf64_Sym); j++)
+            if (syms[j].st_name && 0 == strcmp(strtab + syms[j].st_name, name)) {
+                addr = syms[j].st_value;
+                break;
+            }
+    }
+    munmap((void *) ptr, statBuffer.st_size);
+    return addr;
+}
@@ -0,0 +1,125 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * fuse.c - Superinstruction fusion for common guest idioms.
+ *
+ * After the run loop decodes an instruction that can start an idiom, it
+ * offers it to fuse_exec, which peeks at the words that follow and, if
+ * they complete the idiom, executes the whole group in one call. The
+ * later instructions of a group are never decoded into an instr_t; their
+ * fields are pulled straight out of the instruction words. Registers,
+ * NZCV, memory and PC end up exactly as if each instruction had gone
+ * through the stages on its own.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include "machine.h"
+#include "instr.h"
+#include "instructions.h"
+#include "fuse.h"
+#include "mmio.h"
+
+extern __thread machine_t guest;
+
+fuse_stats_t fuse_stats;
+
+static char *fuse_names[FUSE_NUM_KINDS] = {"SUBS+B.cond", "MOVZ+MOVK", "ADD+LDUR/STUR"};
+
+const char *fuse_name(const fuse_kind_t kind) {return fuse_names[kind];}
+
+static inline unsigned fused(const fuse_kind_t kind, const unsigned n) {
+    fuse_stats.groups[kind]++;
+    fuse_stats.instrs[kind] += n;
+    return n;
+}
+
+static inline int64_t sext(const uint64_t v, const unsigned width) {
+    return ((int64_t) (v << (64 - width))) >> (64 - width);
+}
+
+/*
+ * SUBS followed by B.cond: set the result and pending flags, then branch.
+ */
+
+static unsigned fuse_cmp_branch(instr_t *const insn, const uint64_t pc) {
+    int32_t next = mem_read_I(pc + 4);
+    if (OP_B_COND != itable[GETBF(next, 21, 11)] || GETBF(next, 4, 1)) return 0;
+    execute_SUBS_RR(insn);
+    common_writeback_alu_X_cc(insn);
+    int64_t offset = sext(GETBF(next, 5, 19), 19) << 2;
+    guest.proc->regs[R_PC].xval = cond_holds(GETBF(next, 0, 4)) ? pc + 4 + offset : pc + 8;
+    return fused(FUSE_CMP_BRANCH, 2);
+}
+
+/*
+ * MOVZ followed by MOVKs to the same register: build the constant once.
+ */
+
+static unsigned fuse_move_wide(instr_t *const insn, const uint64_t pc, const uint64_t budget) {
+    unsigned d = GETBF(insn->insnbits, 0, 5);
+    uint64_t val = ((uint64_t) insn->imm) << insn->shift;
+    unsigned n = 1;
+    while (n < 4 && n < budget) {
+        int32_t next = mem_read_I(pc + 4*n);
+        if (OP_MOVK != itable[GETBF(next, 21, 11)] || d != GETBF(next, 0, 5)) break;
+        unsigned shift = 16 * GETBF(next, 21, 2);
+        val = (val & ~(0xFFFFULL << shift)) | ((uint64_t) GETBF(next, 5, 16) << shift);
+        n++;
+    }
+    if (n < 2) return 0;
+    guest.proc->regs[insn->dst].xval = val;
+    guest.proc->regs[R_PC].xval = pc + 4*n;
+    return fused(FUSE_MOVE_WIDE, n);
+}
+
+/*
+ * ADD (immediate) whose result is the base register of the load or store
+ * that follows it.
+ */
+
+static unsigned fuse_addr_mem(instr_t *const insn, const uint64_t pc) {
+    int32_t next = mem_read_I(pc + 4);
+    opcode_t op = itable[GETBF(next, 21, 11)];
+    if (OP_LDUR != op && OP_STUR != op && OP_LDURB != op && OP_STURB != op) return 0;
+    if (REG_SRC(GETBF(next, 5, 5), true) != insn->dst) return 0;
+    uint64_t addr = insn->opnd1.xval + insn->imm + sext(GETBF(next, 12, 9), 9);
+    if (mmio_is_reserved(addr)) return 0; // Devices must see the ADD retired.
+
+    gpregval_t *regs = guest.proc->regs;
+    execute_ADD_RI(insn);
+    regs[insn->dst].xval = insn->val_ex.xval;
+    unsigned t = GETBF(next, 0, 5);
+    switch (op) {
+        case OP_LDUR: regs[REG_DST(t, false)].xval = mem_read_L(addr); break;
+        case OP_LDURB: regs[REG_DST(t, false)].xval = (uint8_t) mem_read_B(addr); break;
+        case OP_STUR: mem_write_L(addr, regs[REG_SRC(t, false)].xval); break;
+        case OP_STURB: mem_write_B(addr, regs[REG_SRC(t, false)].xval); break;
+        default: assert(false); break;
+    }
+    guest.proc->regs[R_PC].xval = pc + 8;
+    return fused(FUSE_ADDR_MEM, 2);
+}
+
+/*
+ * Try to execute insn, already fetched and decoded at PC, together with
+ * the instructions after it as one fused group. Returns the number of
+ * guest instructions retired, with PC past them, or 0 if insn does not
+ * start a recognized idiom, in which case nothing has been executed. A
+ * group never covers more than budget instructions.
+ */
+
+unsigned fuse_exec(instr_t *const insn, const uint64_t budget) {
+    if (budget < 2) return 0;
+    uint64_t pc = guest.proc->regs[R_PC].xval;
+    switch (insn->op) {
+        case OP_SUBS_RR: return fuse_cmp_branch(insn, pc);
+        case OP_MOVZ: return fuse_move_wide(insn, pc, budget);
+        case OP_ADD_RI: return fuse_addr_mem(insn, pc);
+        default: return 0;
+    }
+}
@@ -0,0 +1,33 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * globals.c - The emulator's global state and the options handle_args
+ * sets. ae, and the tools and benches that link the emulator's sources
+ * without archsim.c, all take them from here.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include "archsim.h"
+
+__thread machine_t guest;
+opcode_t itable[2<<11];
+FILE *infile, *outfile, *errfile;
+char *ae_prompt;
+char *elf_file, *trace_file;
+bool no_fusion = false;
+unsigned jit_threshold = 0;
+uint64_t max_num_instr = MAX_NUM_INSTR;
+bool roi_only = false;
+uint64_t ff_instrs = 0;
+char *ff_until = NULL;
+uint64_t warmup_instrs = 0;
+char *bbv_file = NULL;
+uint64_t bbv_interval = BBV_DEFAULT_INTERVAL;
+uint64_t sample_period = 0;
+uint64_t sample_len = SAMPLE_DEFAULT_LEN;
+unsigned sample_jobs = 0;
+unsigned guest_cores = 0;
+uint64_t smp_quantum = 0;
+char *coh_config = NULL;
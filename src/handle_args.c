@@ -20,7 +20,7 @@ void handle_args(int argc, char **argv) {
     outfile = stdout;
     errfile = stderr;
 
-    while ((option = getopt(argc, argv, "i:o:")) != -1) {
+    while ((option = getopt(argc, argv, "i:o:t:nJ:b:Rm:f:F:w:V:I:P:L:j:c:d:C:")) != -1) {
         switch(option) {
             case 'i':
                 if ((infile = fopen(optarg, "r")) == NULL) {
@@ -38,12 +38,78 @@ void handle_args(int argc, char **argv) {
                     return;
                 }
                 break;
+            case 't':
+                trace_file = optarg;
+                break;
+            case 'n':
+                no_fusion = true;
+                break;
+            case 'J':
+                jit_threshold = atoi(optarg);
+                break;
+            case 'b':
+                max_num_instr = strtoull(optarg, NULL, 0);
+                break;
+            case 'R':
+                roi_only = true;
+                break;
+            case 'm':
+                if (!detail_add_model(optarg)) {
+                    logging(LOG_FATAL, "Bad or too many timing models");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'f':
+                ff_instrs = strtoull(optarg, NULL, 0);
+                break;
+            case 'F':
+                ff_until = optarg;
+                break;
+            case 'w':
+                warmup_instrs = strtoull(optarg, NULL, 0);
+                break;
+            case 'V':
+                bbv_file = optarg;
+                break;
+            case 'I':
+                bbv_interval = strtoull(optarg, NULL, 0);
+                break;
+            case 'P':
+                sample_period = strtoull(optarg, NULL, 0);
+                break;
+            case 'L':
+                sample_len = strtoull(optarg, NULL, 0);
+                break;
+            case 'j':
+                sample_jobs = atoi(optarg);
+                break;
+            case 'c':
+                if (0 == (guest_cores = atoi(optarg))) {
+                    logging(LOG_FATAL, "A guest needs at least one core");
+                    exit(EXIT_FAILURE);
+                }
+                break;
+            case 'd':
+                smp_quantum = strtoull(optarg, NULL, 0);
+                break;
+            case 'C':
+                coh_config = optarg;
+                break;
             default:
                 sprintf(printbuf, "Ignoring unknown option %c", optopt);
                 logging(LOG_INFO, printbuf);
                 break;
         }
     }
+    if (optind < argc) elf_file = argv[optind++];
+    else {
+        // Too long for logging's buffer.
+        fprintf(errfile, "Usage: ae [-i infile] [-o outfile] [-t tracefile] [-n] [-J threshold] [-b budget] [-R]\n"
+                "          [-m model]... [-f instrs] [-F pc|symbol] [-w instrs]\n"
+                "          [-V bbvfile] [-I interval] [-P period] [-L instrs] [-j jobs]\n"
+                "          [-c cores] [-d quantum] [-C config] executable\n");
+        exit(EXIT_FAILURE);
+    }
     for(; optind < argc; optind++) { // when some extra arguments are passed
         assert(strlen(argv[optind])< BUF_LEN);
         sprintf(printbuf, "Ignoring extra argument %s", argv[optind]);
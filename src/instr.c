@@ -20,46 +20,45 @@
 #include "machine.h"
 #include "instructions.h"
 
-extern machine_t guest;
+extern __thread machine_t guest;
+
+// For opcodes that are never dispatched (aliases).
+static inline void handler_none(instr_t *const insn) {}
 
 inline unsigned safe_GETBF(int32_t src, unsigned frompos, unsigned width) {
     return ((((unsigned) src) & (((1 << width) - 1) << frompos)) >> frompos);
 }
 
-static inline void init_itable_entry(opcode_t op, unsigned idx) {itable[idx] = op;}
+/*
+ * Initialize the itable from instr_spec.h. Called from interface.c.
+ *
+ * An 11-bit index i maps to op if the index's bits agree with op's
+ * encoding wherever the top 11 bits of its mask are set. An index that
+ * maps to more than one op is marked OP_NONE, for match_op to resolve.
+ */
 
-static inline void init_itable_range(opcode_t op, unsigned idx1, unsigned idx2) {
-    for (unsigned i = idx1; i <= idx2; i++) itable[i] = op;
+void init_itable(void) {
+    for (int i = 0; i < (2<<11); i++) itable[i] = OP_ERROR;
+    for (unsigned i = 0; i < (2<<11); i++) {
+#define INSTR(op, name, mask, value, is_32, fmt, ex, mem, wb, upc) \
+        if ((mask) && (((i << 21) ^ (value)) & (mask) & 0xFFE00000U) == 0) \
+            itable[i] = OP_ERROR == itable[i] ? OP_##op : OP_NONE;
+#include "instr_spec.h"
+#undef INSTR
+    }
 }
 
 /*
- * Initialize the itable. Called from interface.c.
- * Do not re-write.
+ * The opcode whose full mask and value match w, or OP_ERROR. For the
+ * itable entries several opcodes share.
  */
 
-void init_itable(void) {
-    for (int i = 0; i < (2<<11); i++) itable[i] = OP_ERROR;
-    init_itable_entry(OP_LDURB, 0x1c2U);
-    init_itable_entry(OP_LDUR, 0x7c2U);
-    init_itable_entry(OP_STURB, 0x1c0U);
-    init_itable_entry(OP_STUR, 0x7c0U);
-    init_itable_range(OP_MOVK, 0x794U, 0x797U);
-    init_itable_range(OP_MOVZ, 0x694U, 0x697U);
-    init_itable_range(OP_ADD_RI, 0x088U, 0x08bU);
-    init_itable_entry(OP_ADDS_RR, 0x558U);
-    init_itable_entry(OP_SUBS_RR, 0x758U);
-    init_itable_entry(OP_MVN, 0x551U);
-    init_itable_entry(OP_ORR_RR, 0x550U);
-    init_itable_entry(OP_EOR_RR, 0x650U);
-    init_itable_entry(OP_ANDS_RR, 0x750U);
-    init_itable_range(OP_UBFM, 0x69aU, 0x69bU); // LSL, LSR share the same opcode
-    init_itable_range(OP_ASR, 0x49aU, 0x49bU);
-    init_itable_range(OP_B, 0x0a0U, 0x0bfU);
-    init_itable_range(OP_B_COND, 0x2a0U, 0x2a7U);
-    init_itable_range(OP_BL, 0x4a0U, 0x4bfU);
-    init_itable_entry(OP_RET, 0x6b2U);
-    init_itable_entry(OP_NOP, 0x6a8U);
-    init_itable_entry(OP_HLT, 0x6a2U);
+opcode_t match_op(const uint32_t w) {
+#define INSTR(op, name, mask, value, is_32, fmt, ex, mem, wb, upc) \
+    if ((mask) && ((w) & (mask)) == (value)) return OP_##op;
+#include "instr_spec.h"
+#undef INSTR
+    return OP_ERROR;
 }
 
 /*
@@ -69,227 +68,260 @@ void init_itable(void) {
  */
 
 void fetch_instr(instr_t *const insn) {
-    insn->insnbits = mem_read_I(guest.proc->PC.bits->xval);
+    insn->insnbits = mem_read_I(guest.proc->regs[R_PC].xval);
     return;
 }
 
 /*
- * Decode and read operands: top level dispatcher (partially implemented).
+ * Decode and read operands.
  *
- * STUDENT TODO:
- * Finish dispatcher.
- * Finish lower levels in instruction-specific files in the instr/ subdirectory.
+ * Each format below pulls its fields out with constant masks and reads
+ * the registers it needs. decode_instr picks one per opcode through the
+ * fmt column of instr_spec.h, so the compiler sees a separate, fully
+ * specialized decoder for every encoding.
  */
 
+#define RD(w)       EXTRACT(w, 0x1FU, 0)                // Also Rt.
+#define RN(w)       EXTRACT(w, 0x3E0U, 5)
+#define RM(w)       EXTRACT(w, 0x1F0000U, 16)
+#define IMM6(w)     EXTRACT(w, 0xFC00U, 10)             // Shift amount; imms for bitfield moves.
+#define IMMR(w)     EXTRACT(w, 0x3F0000U, 16)
+#define IMM12(w)    EXTRACT(w, 0x3FFC00U, 10)
+#define IMM16(w)    EXTRACT(w, 0x1FFFE0U, 5)
+#define HW(w)       EXTRACT(w, 0x600000U, 21)
+#define COND(w)     EXTRACT(w, 0xFU, 0)
+#define SIMM9(w)    ((int64_t) ((int32_t) ((w) << 11) >> 23))
+#define SIMM19(w)   ((int64_t) ((int32_t) ((w) << 8) >> 13))
+#define SIMM26(w)   ((int64_t) ((int32_t) ((w) << 6) >> 6))
+
+#define REG(r)      (guest.proc->regs[r].xval)
+
+static inline void decode_F_LOAD(instr_t *const insn, const uint32_t w) {
+    insn->dst = REG_DST(RD(w), false);
+    insn->src1 = REG_SRC(RN(w), true);
+    insn->imm = SIMM9(w);
+    insn->opnd1.xval = REG(insn->src1);
+    insn->opnd2.xval = insn->imm;
+}
+
+static inline void decode_F_STORE(instr_t *const insn, const uint32_t w) {
+    insn->src1 = REG_SRC(RN(w), true);
+    insn->src2 = REG_SRC(RD(w), false);
+    insn->imm = SIMM9(w);
+    insn->opnd1.xval = REG(insn->src1);
+    insn->opnd2.xval = REG(insn->src2); // Value to store.
+}
+
+// Exclusive forms: the address is the base register alone.
+static inline void decode_F_LDX(instr_t *const insn, const uint32_t w) {
+    insn->dst = REG_DST(RD(w), false);
+    insn->src1 = REG_SRC(RN(w), true);
+    insn->opnd1.xval = REG(insn->src1);
+}
+
+static inline void decode_F_STX(instr_t *const insn, const uint32_t w) {
+    insn->dst = REG_DST(RM(w), false); // Status.
+    insn->src1 = REG_SRC(RN(w), true);
+    insn->src2 = REG_SRC(RD(w), false);
+    insn->opnd1.xval = REG(insn->src1);
+    insn->opnd2.xval = REG(insn->src2); // Value to store.
+}
+
+static inline void decode_F_MOVZ(instr_t *const insn, const uint32_t w) {
+    insn->dst = REG_DST(RD(w), false);
+    insn->imm = IMM16(w);
+    insn->shift = 16 * HW(w);
+    insn->opnd2.xval = insn->imm;
+}
+
+static inline void decode_F_MOVK(instr_t *const insn, const uint32_t w) {
+    decode_F_MOVZ(insn, w);
+    insn->src1 = REG_SRC(RD(w), false); // MOVK keeps the other bits of Rd.
+    insn->opnd1.xval = REG(insn->src1);
+}
+
+static inline void decode_F_ADD_IMM(instr_t *const insn, const uint32_t w) {
+    insn->dst = REG_DST(RD(w), true);
+    insn->src1 = REG_SRC(RN(w), true);
+    insn->imm = (w & 0x400000U) ? IMM12(w) << 12 : IMM12(w);
+    insn->opnd1.xval = REG(insn->src1);
+    insn->opnd2.xval = insn->imm;
+}
+
+// Shifted-register forms. Only LSL shifts are in the itable.
+static inline void decode_F_REG3(instr_t *const insn, const uint32_t w) {
+    insn->dst = REG_DST(RD(w), false);
+    insn->src1 = REG_SRC(RN(w), false);
+    insn->src2 = REG_SRC(RM(w), false);
+    insn->shift = IMM6(w);
+    insn->opnd1.xval = REG(insn->src1);
+    insn->opnd2.xval = REG(insn->src2) << insn->shift;
+}
+
+static inline void decode_F_REG2(instr_t *const insn, const uint32_t w) {
+    insn->dst = REG_DST(RD(w), false);
+    insn->src2 = REG_SRC(RM(w), false);
+    insn->shift = IMM6(w);
+    insn->opnd2.xval = REG(insn->src2) << insn->shift;
+}
+
+// The rotate amount (immr) goes in shift and the top bit of the field (imms) in imm.
+static inline void decode_F_BFM(instr_t *const insn, const uint32_t w) {
+    insn->dst = REG_DST(RD(w), false);
+    insn->src1 = REG_SRC(RN(w), false);
+    insn->imm = IMM6(w);
+    insn->shift = IMMR(w);
+    insn->opnd1.xval = REG(insn->src1);
+}
+
+static inline void decode_F_ASR(instr_t *const insn, const uint32_t w) {
+    insn->dst = REG_DST(RD(w), false);
+    insn->src1 = REG_SRC(RN(w), false);
+    insn->shift = IMMR(w);
+    insn->opnd1.xval = REG(insn->src1);
+}
+
+static inline void decode_F_B(instr_t *const insn, const uint32_t w) {
+    uint64_t pc = REG(R_PC);
+    insn->imm = SIMM26(w) * 4;
+    insn->next_PC = pc + 4;
+    insn->branch_PC = pc + insn->imm;
+}
+
+static inline void decode_F_BL(instr_t *const insn, const uint32_t w) {
+    decode_F_B(insn, w);
+    insn->dst = 30;
+}
+
+static inline void decode_F_B_COND(instr_t *const insn, const uint32_t w) {
+    uint64_t pc = REG(R_PC);
+    insn->cond = COND(w);
+    insn->imm = SIMM19(w) * 4;
+    insn->next_PC = pc + 4;
+    insn->branch_PC = pc + insn->imm;
+}
+
+static inline void decode_F_RET(instr_t *const insn, const uint32_t w) {
+    insn->src1 = REG_SRC(RN(w), false);
+    insn->opnd1.xval = REG(insn->src1);
+}
+
+static inline void decode_F_HLT(instr_t *const insn, const uint32_t w) {
+    insn->imm = IMM16(w);
+}
+
+static inline void decode_F_NONE(instr_t *const insn, const uint32_t w) {}
+static inline void decode_F_ALIAS(instr_t *const insn, const uint32_t w) {}
+
 void decode_instr(instr_t *const insn) {
-    // Don't change the next three lines.
-    int32_t instr = insn->insnbits;
-    unsigned op = GETBF(instr, 21, 11);
-    insn->op = itable[op];
+    uint32_t instr = insn->insnbits;
+    insn->op = lookup_op(instr);
+    insn->dst = insn->src1 = insn->src2 = R_NONE;
 
     switch(insn->op) {
         case OP_NONE: assert(false); break;
-        case OP_LDURB: decode_LDURB(insn); break;
-        case OP_LDUR: break;
-        case OP_STURB: decode_STURB(insn); break;
-        case OP_STUR: break;
-        case OP_MOVK: break;
-        case OP_MOVZ: break;
-        case OP_ADD_RI: decode_ADD_RI(insn); break;
-        case OP_ADDS_RR: break;
-        case OP_SUBS_RR: break;
-        case OP_MVN: break;
-        case OP_ORR_RR: break;
-        case OP_EOR_RR: break;
-        case OP_ANDS_RR: break;
-        case OP_LSL: break;
-        case OP_LSR: break;
-        case OP_UBFM: break;
-        case OP_ASR: break;
-        case OP_B: break;
-        case OP_B_COND: break;
-        case OP_BL: break;
-        case OP_RET: break;
-        case OP_NOP: decode_NOP(insn); break;
-        case OP_HLT: decode_HLT(insn); break;
+#define INSTR(op, name, mask, value, is_32_, fmt, ex, mem, wb, upc) \
+        case OP_##op: \
+            assert(((instr) & (mask)) == (value)); \
+            insn->is_32 = is_32_; \
+            decode_##fmt(insn, instr); \
+            break;
+#include "instr_spec.h"
+#undef INSTR
         case OP_ERROR: assert(false); break;
     }
     return;
 }
 
 /*
- * Execute: top level dispatcher (partially implemented).
- *
- * STUDENT TODO:
- * Finish dispatcher.
- * Finish lower levels in instruction-specific files in the instr/ subdirectory.
+ * Execute: top level dispatcher. The handlers are in the instr/
+ * subdirectory, one file per instruction.
  */
 
 void execute_instr(instr_t *const insn) {
     switch(insn->op) {
         case OP_NONE: assert(false); break;
-        case OP_LDURB: execute_LDURB(insn); break;
-        case OP_LDUR: break;
-        case OP_STURB: execute_STURB(insn); break;
-        case OP_STUR: break;
-        case OP_MOVK: break;
-        case OP_MOVZ: break;
-        case OP_ADD_RI: execute_ADD_RI(insn); break;
-        case OP_ADDS_RR: break;
-        case OP_SUBS_RR: break;
-        case OP_MVN: break;
-        case OP_ORR_RR: break;
-        case OP_EOR_RR: break;
-        case OP_ANDS_RR: break;
-        case OP_LSL: break;
-        case OP_LSR: break;
-        case OP_UBFM: break;
-        case OP_ASR: break;
-        case OP_B: break;
-        case OP_B_COND: break;
-        case OP_BL: break;
-        case OP_RET: break;
-        case OP_NOP: execute_NOP(insn); break;
-        case OP_HLT: execute_HLT(insn); break;
+#define INSTR(op, name, mask, value, is_32, fmt, ex, mem, wb, upc) case OP_##op: ex(insn); break;
+#include "instr_spec.h"
+#undef INSTR
         case OP_ERROR: assert(false); break;
     }
     return;
 }
 
 /*
- * Access memory: top level dispatcher (partially implemented).
- *
- * STUDENT TODO:
- * Finish dispatcher using lower level routines in the file instr/commmon_memory.c.
+ * Access memory: top level dispatcher, using the routines in
+ * instr/common_memory.c.
  */
 
 void memory_instr(instr_t *const insn) {
     switch(insn->op) {
         case OP_NONE: assert(false); break;
-        case OP_LDURB: common_memory_load_BW(insn); break;
-        case OP_LDUR: break;
-        case OP_STURB: common_memory_store_WB(insn); break;
-        case OP_STUR: break;
-        case OP_MOVK: break;
-        case OP_MOVZ: break;
-        case OP_ADD_RI: common_memory_none(insn); break;
-        case OP_ADDS_RR: break;
-        case OP_SUBS_RR: break;
-        case OP_MVN: break;
-        case OP_ORR_RR: break;
-        case OP_EOR_RR: break;
-        case OP_ANDS_RR: break;
-        case OP_LSL: break;
-        case OP_LSR: break;
-        case OP_UBFM: break;
-        case OP_ASR: break;
-        case OP_B: break;
-        case OP_B_COND: break;
-        case OP_BL: break;
-        case OP_RET: break;
-        case OP_NOP: common_memory_none(insn); break;
-        case OP_HLT: common_memory_none(insn); break;
+#define INSTR(op, name, mask, value, is_32, fmt, ex, mem, wb, upc) case OP_##op: mem(insn); break;
+#include "instr_spec.h"
+#undef INSTR
         case OP_ERROR: assert(false); break;
     }
     return;
 }
 
 /*
- * Write back to register file: top level dispatcher (partially implemented).
- *
- * STUDENT TODO:
- * Finish dispatcher using lower level routines in the file instr/common_writeback.c.
+ * Write back to register file: top level dispatcher, using the routines
+ * in instr/common_writeback.c.
  */
 
 void wback_instr(instr_t *const insn) {
     switch(insn->op) {
         case OP_NONE: assert(false); break;
-        case OP_LDURB: common_writeback_mem_W(insn); break;
-        case OP_LDUR: 
-            break;
-        case OP_STURB: case OP_STUR: common_writeback_none(insn); break;
-        case OP_MOVK: case OP_MOVZ: 
-            break;
-        case OP_ADD_RI:
-        case OP_ADDS_RR: 
-        case OP_SUBS_RR: 
-        case OP_MVN: 
-        case OP_ORR_RR: 
-        case OP_EOR_RR: 
-        case OP_ANDS_RR: 
-        case OP_LSL: case OP_LSR: case OP_UBFM: case OP_ASR: 
-            common_writeback_alu_X(insn); break;
-        case OP_B: break;
-        case OP_B_COND: break;
-        case OP_BL: break;
-        case OP_RET: break;
-        case OP_NOP: common_writeback_none(insn); break;
-        case OP_HLT: common_writeback_none(insn); break;
+#define INSTR(op, name, mask, value, is_32, fmt, ex, mem, wb, upc) case OP_##op: wb(insn); break;
+#include "instr_spec.h"
+#undef INSTR
         case OP_ERROR: assert(false); break;
     }
     return;
 }
 
 /*
- * Update PC: top level dispatcher (partially implemented).
- *
- * STUDENT TODO:
- * Finish dispatcher using lower level routines in the file instr/common_update_pc.c.
+ * Update PC: top level dispatcher, using the routines in
+ * instr/common_update_pc.c.
  */
 
 void update_pc_instr(instr_t *const insn) {
     switch(insn->op) {
-        case OP_NONE: 
-            assert(false); break;
-        case OP_LDURB: case OP_LDUR: 
-        case OP_STURB: case OP_STUR: 
-        case OP_MOVK: case OP_MOVZ: 
-        case OP_ADD_RI: case OP_ADDS_RR: case OP_SUBS_RR: 
-        case OP_MVN: 
-        case OP_ORR_RR: case OP_EOR_RR: case OP_ANDS_RR: 
-        case OP_LSL: case OP_LSR: case OP_UBFM: case OP_ASR: 
-            update_pc_next(insn); break;
-        case OP_B: 
-            break;
-        case OP_B_COND: 
-            break;
-        case OP_BL: 
-            break;
-        case OP_RET: 
-            break;
-        case OP_NOP: update_pc_next(insn); break;
-        case OP_HLT: update_pc_halt(insn); break;
+        case OP_NONE: assert(false); break;
+#define INSTR(op, name, mask, value, is_32, fmt, ex, mem, wb, upc) case OP_##op: upc(insn); break;
+#include "instr_spec.h"
+#undef INSTR
         case OP_ERROR: assert(false); break;
     }
     return;
 }
 
+/*
+ * Decode, execute, memory and writeback, one function per opcode, for
+ * code that knows the opcode without the itable: aeaot's native code
+ * calls step_<op> with a constant word, which the compiler can then
+ * decode at build time. PC is not updated.
+ */
+
+#define INSTR(op_, name, mask, value, is_32_, fmt, ex, mem, wb, upc) \
+void step_##op_(const uint32_t w) { \
+    instr_t insn = {.insnbits = w, .op = OP_##op_, .is_32 = is_32_, \
+                    .dst = R_NONE, .src1 = R_NONE, .src2 = R_NONE}; \
+    decode_##fmt(&insn, w); \
+    ex(&insn); \
+    mem(&insn); \
+    wb(&insn); \
+}
+#include "instr_spec.h"
+#undef INSTR
+
 #ifdef DEBUG
 static char *opcode_names[] = {
     "ERR ", 
-    "LDURB ",
-    "LDUR ",
-    "STURB ",
-    "STUR ",
-    "MOVK ",
-    "MOVZ ",
-    "ADD ",
-    "ADDS ",
-    "SUBS ",
-    "MVN ",
-    "ORR ",
-    "EOR ",
-    "ANDS ",
-    "LSL ",
-    "LSR ",
-    "UBFM ",
-    "ASR ",
-    "B ",
-    "B.cond ",
-    "BL ",
-    "RET ",
-    "NOP ",
-    "HLT ",
+#define INSTR(op, name, mask, value, is_32, fmt, ex, mem, wb, upc) name " ",
+#include "instr_spec.h"
+#undef INSTR
 };
 
 static char *cond_names[] = {
@@ -310,15 +342,15 @@ void show_instr(const instr_t * insn, const proc_stage_t stage) {
 #ifdef DEBUG
     switch (stage) {
         case S_FETCH:
-            printf("F:[%08lX  %08X]\n", guest.proc->PC.bits->xval, insn->insnbits);
+            printf("F:[%08lX  %08X]\n", guest.proc->regs[R_PC].xval, insn->insnbits);
             break;
         case S_DECODE:
             printf(" D:\t\t\t[%s\t%s\t%s\t%s\t%s\t%016lX\t%d]\n", 
                 opcode_names[insn->op], 
                 insn->cond ? cond_names[insn->cond] : "--",
-                insn->dst ? insn->dst->name : "---",
-                insn->src1 ? insn->src1->name : "---",
-                insn->src2 ? insn->src2->name : "---",
+                reg_name(insn->dst, insn->is_32),
+                reg_name(insn->src1, insn->is_32),
+                reg_name(insn->src2, insn->is_32),
                 insn->imm, 
                 insn->shift);
             break;
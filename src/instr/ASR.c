@@ -0,0 +1,19 @@
+#include <assert.h>
+#include "ASR.h"
+#include "machine.h"
+
+extern __thread machine_t guest;
+
+/*
+ * ASR (immediate) is the SBFM alias with imms = 63 (31 for the W form).
+ */
+
+void execute_ASR(instr_t * const insn) {
+    insn->val_ex.xval = (int64_t) insn->opnd1.xval >> insn->shift;
+    return;
+}
+
+void execute_ASR_W(instr_t * const insn) {
+    insn->val_ex.xval = (uint32_t) (insn->opnd1.wval >> insn->shift);
+    return;
+}
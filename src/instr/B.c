@@ -0,0 +1,10 @@
+#include <assert.h>
+#include "B.h"
+#include "machine.h"
+
+extern __thread machine_t guest;
+
+void execute_B(instr_t * const insn) {
+    insn->val_ex.xval = insn->branch_PC;
+    return;
+}
@@ -0,0 +1,14 @@
+#include <assert.h>
+#include "BL.h"
+#include "machine.h"
+
+extern __thread machine_t guest;
+
+/*
+ * The return address is the value written back to X30.
+ */
+
+void execute_BL(instr_t * const insn) {
+    insn->val_ex.xval = insn->next_PC;
+    return;
+}
@@ -0,0 +1,11 @@
+#include <assert.h>
+#include "B_COND.h"
+#include "common_cc.h"
+#include "machine.h"
+
+extern __thread machine_t guest;
+
+void execute_B_COND(instr_t * const insn) {
+    insn->val_ex.xval = cond_holds(insn->cond) ? insn->branch_PC : insn->next_PC;
+    return;
+}
@@ -0,0 +1,8 @@
+#include <assert.h>
+#include "EOR_RR.h"
+#include "common_execute.h"
+#include "machine.h"
+
+extern __thread machine_t guest;
+
+EXECUTE_WX(EOR_RR, a ^ b)
@@ -0,0 +1,13 @@
+#include <assert.h>
+#include <stdlib.h>
+#include "err_handler.h"
+#include "LDXR.h"
+#include "machine.h"
+
+extern __thread machine_t guest;
+
+// The address is the base register alone; the memory stage sets the monitor.
+void execute_LDXR(instr_t * const insn) {
+    insn->val_ex.xval = insn->opnd1.xval;
+    return;
+}
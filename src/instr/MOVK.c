@@ -0,0 +1,11 @@
+#include <assert.h>
+#include "MOVK.h"
+#include "machine.h"
+
+extern __thread machine_t guest;
+
+void execute_MOVK(instr_t * const insn) {
+    uint64_t mask = 0xFFFFULL << insn->shift;
+    insn->val_ex.xval = (insn->opnd1.xval & ~mask) | (insn->opnd2.xval << insn->shift);
+    return;
+}
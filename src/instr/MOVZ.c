@@ -0,0 +1,10 @@
+#include <assert.h>
+#include "MOVZ.h"
+#include "machine.h"
+
+extern __thread machine_t guest;
+
+void execute_MOVZ(instr_t * const insn) {
+    insn->val_ex.xval = insn->opnd2.xval << insn->shift;
+    return;
+}
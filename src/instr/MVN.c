@@ -0,0 +1,12 @@
+#include <assert.h>
+#include "MVN.h"
+#include "common_execute.h"
+#include "machine.h"
+
+extern __thread machine_t guest;
+
+/*
+ * MVN is ORN with XZR as the first operand, so only Rm is read.
+ */
+
+EXECUTE_WX(MVN, ~b)
@@ -0,0 +1,10 @@
+#include <assert.h>
+#include "RET.h"
+#include "machine.h"
+
+extern __thread machine_t guest;
+
+void execute_RET(instr_t * const insn) {
+    insn->val_ex.xval = insn->opnd1.xval;
+    return;
+}
@@ -0,0 +1,12 @@
+#include <assert.h>
+#include <stdlib.h>
+#include "err_handler.h"
+#include "STUR.h"
+#include "machine.h"
+
+extern __thread machine_t guest;
+
+void execute_STUR(instr_t * const insn) {
+    insn->val_ex.xval = insn->opnd1.xval + insn->imm;
+    return;
+}
@@ -0,0 +1,14 @@
+#include <assert.h>
+#include <stdlib.h>
+#include "err_handler.h"
+#include "STXR.h"
+#include "machine.h"
+
+extern __thread machine_t guest;
+
+// As for LDXR. The memory stage leaves the status (0 if the store was
+// made, 1 if not) in val_mem for writeback to Ws.
+void execute_STXR(instr_t * const insn) {
+    insn->val_ex.xval = insn->opnd1.xval;
+    return;
+}
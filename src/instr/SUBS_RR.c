@@ -0,0 +1,12 @@
+#include <assert.h>
+#include "SUBS_RR.h"
+#include "common_execute.h"
+#include "machine.h"
+
+extern __thread machine_t guest;
+
+/*
+ * Flags are not computed here; see common_cc.c.
+ */
+
+EXECUTE_WX(SUBS_RR, a - b)
@@ -0,0 +1,29 @@
+#include <assert.h>
+#include "UBFM.h"
+#include "machine.h"
+
+extern __thread machine_t guest;
+
+/*
+ * LSL and LSR are aliases of UBFM and are executed as UBFM. The rotate
+ * amount (immr) is kept in shift and the top bit of the field (imms) in imm.
+ * size is the register width, a constant in each of the two forms.
+ */
+
+static inline uint64_t ubfm(const uint64_t x, const unsigned immr, const unsigned imms, const unsigned size) {
+    if (imms >= immr) { // Extract bits imms..immr to the bottom (LSR when imms is size-1).
+        unsigned width = imms - immr + 1;
+        return width < 64 ? (x >> immr) & ((1ULL << width) - 1) : x >> immr;
+    }                   // Insert bits imms..0 at size-immr (LSL when imms is immr-1).
+    return (x & ((1ULL << (imms + 1)) - 1)) << (size - immr);
+}
+
+void execute_UBFM(instr_t * const insn) {
+    insn->val_ex.xval = ubfm(insn->opnd1.xval, insn->shift, insn->imm, 64);
+    return;
+}
+
+void execute_UBFM_W(instr_t * const insn) {
+    insn->val_ex.xval = (uint32_t) ubfm((uint32_t) insn->opnd1.xval, insn->shift, insn->imm, 32);
+    return;
+}
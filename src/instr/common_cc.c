@@ -0,0 +1,134 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ * 
+ * instr/common_cc.c - Lazy evaluation of the NZCV condition flags.
+ * 
+ * Flag-setting instructions do not compute N, Z, C and V. Their writeback
+ * stage records the opcode, both operands and the result in the processor
+ * state, and the flags are only worked out when a consumer asks for them.
+ * B.cond after SUBS (the common compare-and-branch) never builds NZCV at
+ * all: the condition is decided directly from the recorded operands.
+ * 
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/ 
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include "machine.h"
+#include "instr.h"
+#include "common_cc.h"
+
+extern __thread machine_t guest;
+
+/* 
+ * For each condition, bit i is set if the condition holds when NZCV == i.
+ */
+static const uint16_t cond_table[C_NV+1] = {
+    0xF0F0, // EQ: Z
+    0x0F0F, // NE: !Z
+    0xCCCC, // CS: C
+    0x3333, // CC: !C
+    0xFF00, // MI: N
+    0x00FF, // PL: !N
+    0xAAAA, // VS: V
+    0x5555, // VC: !V
+    0x0C0C, // HI: C && !Z
+    0xF3F3, // LS: !C || Z
+    0xAA55, // GE: N == V
+    0x55AA, // LT: N != V
+    0x0A05, // GT: !Z && N == V
+    0xF5FA, // LE: Z || N != V
+    0xFFFF, // AL
+    0xFFFF  // NV (behaves as AL in A64)
+};
+
+/*
+ * NZCV for the three kinds of flag-setting operation, given the operands
+ * and result at the operation's width and the index of its sign bit.
+ */
+
+static inline uint8_t nzcv_add(const uint64_t a, const uint64_t b, const uint64_t r, const unsigned msb) {
+    return PACK_CC((r >> msb) & 1, 0 == r, r < a, (((a ^ r) & (b ^ r)) >> msb) & 1);
+}
+
+static inline uint8_t nzcv_sub(const uint64_t a, const uint64_t b, const uint64_t r, const unsigned msb) {
+    return PACK_CC((r >> msb) & 1, 0 == r, a >= b, (((a ^ b) & (a ^ r)) >> msb) & 1);
+}
+
+static inline uint8_t nzcv_logic(const uint64_t r, const unsigned msb) {
+    return PACK_CC((r >> msb) & 1, 0 == r, 0, 0);
+}
+
+/*
+ * Compute NZCV from the pending flag-setting operation.
+ */
+
+static uint8_t eval_nzcv(const proc_t *p) {
+    const uint64_t a = p->cc_opnd1, b = p->cc_opnd2, r = p->cc_res;
+    switch (p->cc_op) {
+        case OP_ADDS_RR:   return nzcv_add(a, b, r, 63);
+        case OP_SUBS_RR:   return nzcv_sub(a, b, r, 63);
+        case OP_ANDS_RR:   return nzcv_logic(r, 63);
+        case OP_ADDS_RR_W: return nzcv_add((uint32_t) a, (uint32_t) b, (uint32_t) r, 31);
+        case OP_SUBS_RR_W: return nzcv_sub((uint32_t) a, (uint32_t) b, (uint32_t) r, 31);
+        case OP_ANDS_RR_W: return nzcv_logic((uint32_t) r, 31);
+        default: assert(false); return 0;
+    }
+}
+
+/* 
+ * Read NZCV, materializing it if a flag-setting operation is pending.
+ */
+
+uint8_t read_nzcv(void) {
+    proc_t *p = guest.proc;
+    if (OP_NONE != p->cc_op) {
+        p->regs[R_NZCV].ccval = eval_nzcv(p);
+        p->cc_op = OP_NONE;
+    }
+    return p->regs[R_NZCV].ccval;
+}
+
+/* 
+ * Overwrite NZCV, discarding any pending flag-setting operation.
+ */
+
+void write_nzcv(const uint8_t nzcv) {
+    guest.proc->regs[R_NZCV].ccval = nzcv;
+    guest.proc->cc_op = OP_NONE;
+}
+
+/* 
+ * Does cond hold? After a SUBS the signed and unsigned comparisons are
+ * answered straight from the operands and NZCV stays pending; AL and NV
+ * need no flags at all. Anything else goes through the condition table.
+ * SUBS_COND answers at one operand width.
+ */
+
+#define SUBS_COND(U, S) \
+    do { \
+        const U a = (U) p->cc_opnd1, b = (U) p->cc_opnd2; \
+        switch (cond) { \
+            case C_EQ: return a == b; \
+            case C_NE: return a != b; \
+            case C_CS: return a >= b; \
+            case C_CC: return a < b; \
+            case C_HI: return a > b; \
+            case C_LS: return a <= b; \
+            case C_GE: return (S) a >= (S) b; \
+            case C_LT: return (S) a < (S) b; \
+            case C_GT: return (S) a > (S) b; \
+            case C_LE: return (S) a <= (S) b; \
+            default: break; \
+        } \
+    } while (0)
+
+bool cond_holds(const cond_t cond) {
+    const proc_t *p = guest.proc;
+    if (cond >= C_AL) return true;
+    if (OP_SUBS_RR == p->cc_op) SUBS_COND(uint64_t, int64_t);
+    else if (OP_SUBS_RR_W == p->cc_op) SUBS_COND(uint32_t, int32_t);
+    return (cond_table[cond] >> read_nzcv()) & 1;
+}
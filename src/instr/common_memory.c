@@ -12,8 +12,13 @@ void common_memory_load_LX(instr_t * const insn) {
     return;
 }
 
+void common_memory_load_IW(instr_t * const insn) {
+    insn->val_mem.xval = (uint32_t) mem_read_I(insn->val_ex.xval);
+    return;
+}
+
 void common_memory_load_BW(instr_t * const insn) {
-    insn->val_mem.wval = (uint32_t) mem_read_B(insn->val_ex.xval);
+    insn->val_mem.xval = (uint8_t) mem_read_B(insn->val_ex.xval);
     return;
 }
 
@@ -23,12 +28,38 @@ void common_memory_store_XL(instr_t * const insn) {
     return;
 }
 
+void common_memory_store_WI(instr_t * const insn) {
+    mrc_t ret = mem_write_I(insn->val_ex.xval, insn->opnd2.xval);
+    assert(WRITE_SUCCESS == ret);
+    return;
+}
+
 void common_memory_store_WB(instr_t * const insn) {
-    mrc_t ret = mem_write_B(insn->val_ex.wval, insn->opnd2.xval);
+    mrc_t ret = mem_write_B(insn->val_ex.xval, insn->opnd2.xval);
     assert(WRITE_SUCCESS == ret);
     return;
 }
 
+void common_memory_ldx_LX(instr_t * const insn) {
+    insn->val_mem.xval = mem_read_excl(insn->val_ex.xval, 8);
+    return;
+}
+
+void common_memory_ldx_IW(instr_t * const insn) {
+    insn->val_mem.xval = mem_read_excl(insn->val_ex.xval, 4);
+    return;
+}
+
+void common_memory_stx_XL(instr_t * const insn) {
+    insn->val_mem.xval = !mem_write_excl(insn->val_ex.xval, insn->opnd2.xval, 8);
+    return;
+}
+
+void common_memory_stx_WI(instr_t * const insn) {
+    insn->val_mem.xval = !mem_write_excl(insn->val_ex.xval, insn->opnd2.xval, 4);
+    return;
+}
+
 void common_memory_none(instr_t * const insn) {
     return;
 }
\ No newline at end of file
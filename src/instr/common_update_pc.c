@@ -11,8 +11,9 @@
 #include <stdlib.h>
 #include "machine.h"
 #include "instr.h"
+#include "smp.h"
 
-extern machine_t guest;
+extern __thread machine_t guest;
 
 /* 
  * Update PC action for those instructions that fall through to their sequential successor.
@@ -20,7 +21,7 @@ extern machine_t guest;
  * Do not re-write.
  */
 void update_pc_next(instr_t * const insn) {
-    guest.proc->PC.bits->xval += 4;
+    guest.proc->regs[R_PC].xval += 4;
     return;
 }
 
@@ -30,8 +31,25 @@ void update_pc_next(instr_t * const insn) {
  * Do not re-write.
  */
 void update_pc_halt(instr_t * const insn) {
+    if (smp_halt()) return; // The other cores stop too, and smp_run reports.
     exit(EXIT_FAILURE);
     return; // Not reached.
 }
 
-// STUDENT TODO: Add other implementations as needed below this line.
\ No newline at end of file
+// STUDENT TODO: Add other implementations as needed below this line.
+
+/* 
+ * Update PC action for branches, whose execute stage leaves the address of
+ * the next instruction in val_ex.
+ */
+void update_pc_branch(instr_t * const insn) {
+    guest.proc->regs[R_PC].xval = insn->val_ex.xval;
+    return;
+}
+/* 
+ * Update PC action for direct branches whose target was computed in decode.
+ */
+void update_pc_target(instr_t * const insn) {
+    guest.proc->regs[R_PC].xval = insn->branch_PC;
+    return;
+}
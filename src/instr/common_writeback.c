@@ -7,23 +7,51 @@
 #include "instr.h"
 #include "machine.h"
 
+extern __thread machine_t guest;
+
 void common_writeback_alu_X(instr_t * const insn) {
-    insn->dst->bits->xval = insn->val_ex.xval;
+    guest.proc->regs[insn->dst].xval = insn->val_ex.xval;
+    return;
+}
+
+/*
+ * Writeback for flag-setting ALU instructions: record what is needed to
+ * work out NZCV later instead of computing it now (see common_cc.c). The
+ * opcode says which width the flags are for.
+ */
+
+void common_writeback_alu_X_cc(instr_t * const insn) {
+    proc_t *p = guest.proc;
+    p->regs[insn->dst].xval = insn->val_ex.xval;
+    p->cc_op = insn->op;
+    p->cc_opnd1 = insn->opnd1.xval;
+    p->cc_opnd2 = insn->opnd2.xval;
+    p->cc_res = insn->val_ex.xval;
     return;
 }
 
 void common_writeback_alu_W(instr_t * const insn) {
-    insn->dst->bits->wval = insn->val_ex.wval;
+    guest.proc->regs[insn->dst].xval = (uint32_t) insn->val_ex.wval; // Writes to Wn clear the upper half.
+    return;
+}
+
+void common_writeback_alu_W_cc(instr_t * const insn) {
+    proc_t *p = guest.proc;
+    p->regs[insn->dst].xval = (uint32_t) insn->val_ex.wval;
+    p->cc_op = insn->op;
+    p->cc_opnd1 = insn->opnd1.xval;
+    p->cc_opnd2 = insn->opnd2.xval;
+    p->cc_res = insn->val_ex.xval;
     return;
 }
 
 void common_writeback_mem_X(instr_t * const insn) {
-    insn->dst->bits->xval = insn->val_mem.xval;
+    guest.proc->regs[insn->dst].xval = insn->val_mem.xval;
     return;
 }
 
 void common_writeback_mem_W(instr_t * const insn) {
-    insn->dst->bits->wval = insn->val_mem.wval;
+    guest.proc->regs[insn->dst].xval = (uint32_t) insn->val_mem.wval;
     return;
 }
 
@@ -25,9 +25,9 @@ static void print_init_msg(void) {
 }
 
 void init(void) {
-    infile = stdin;
-    outfile = stdout;
-    errfile = stderr;
+    if (! infile) infile = stdin;
+    if (! outfile) outfile = stdout;
+    if (! errfile) errfile = stderr;
     if (! ae_prompt) ae_prompt = default_ae_prompt;
     init_machine("AArch64", 64, L_ENDIAN, L_ENDIAN);
     init_itable();
@@ -0,0 +1,570 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * jit.c - Translation of hot guest basic blocks to x86-64 host code.
+ *
+ * The run loop offers every block head it reaches to jit_run. A head that
+ * has been reached threshold times is translated into the code cache and
+ * from then on runs as host code. Guest state stays in the proc_t context:
+ * translated code keeps a pointer to it in RBX and loads and stores
+ * registers, lazy NZCV and PC there, so the interpreter can pick up after
+ * any exit. Loads and stores go through the same mem_read/mem_write
+ * routines the interpreter uses. An access to a reserved address (a
+ * device; see mmio.h) leaves translated code so that the interpreter
+ * performs it.
+ *
+ * A direct branch leaves its block through a stub that stores the target
+ * PC and returns to jit_run. Once the target is translated, the stub is
+ * overwritten with a jump straight to it (block chaining).
+ *
+ * The remaining instruction budget lives in R12. Each block checks that it
+ * can run to completion before it starts, so instruction counts are the
+ * same as the interpreter's.
+ *
+ * Guest code may be rewritten. translate marks the pages a block was read
+ * from, and a store to a marked page, from translated code or from the
+ * interpreter, sets jit_stale. Translated code checks it after every store
+ * and leaves at once, and jit_run then flushes the whole cache, so no
+ * instruction after the store runs from a stale translation.
+ *
+ * jit_set_barrier names a PC at which jit_run must hand back to the run
+ * loop, however it was reached: no block contains it except as its head,
+ * and a block with it as head is never translated, so nothing chains past
+ * it.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <string.h>
+#include <assert.h>
+#include <sys/mman.h>
+#include "err_handler.h"
+#include "machine.h"
+#include "instr.h"
+#include "instructions.h"
+#include "jit.h"
+#include "ptable.h"
+#include "mmio.h"
+
+extern __thread machine_t guest;
+
+#define JIT_CACHE_SIZE (16 << 20)
+#define JIT_MAX_BLOCK 64            // Guest instructions per block.
+#define JIT_BLOCK_RESERVE (64 << 10) // Enough host code for any one block.
+#define JIT_HASHSIZE 4096
+
+// Values returned by translated code, other than a pointer to a jit_exit_t.
+#define JIT_EXIT_LOOKUP 0   // PC was set by an indirect branch.
+#define JIT_EXIT_INTERP 1   // The instruction at PC must be interpreted.
+
+// Host registers.
+#define RAX 0
+#define RCX 1
+#define RSI 6
+#define RDI 7
+
+// x86 condition codes (low nibble of Jcc).
+#define X_B  0x2
+#define X_AE 0x3
+#define X_NE 0x5
+#define X_BE 0x6
+
+#define REG_OFF(i) ((int32_t) (offsetof(proc_t, regs) + (i) * sizeof(gpregval_t)))
+#define PROC_OFF(f) ((int32_t) offsetof(proc_t, f))
+
+typedef struct jit_exit {
+    uint8_t *stub;      // Exit stub, patched to a jump once the target is translated.
+    uint64_t target;    // Guest PC the exit leads to.
+} jit_exit_t;
+
+typedef struct jit_block {
+    uint64_t pc;
+    unsigned count;     // Times reached in the interpreter.
+    unsigned len;       // Guest instructions.
+    bool dead;          // Cannot be translated; stop trying.
+    uint8_t *code;      // Entry point, or NULL if not translated.
+    jit_exit_t exits[2];
+    struct jit_block *next;
+} jit_block_t;
+
+typedef uint64_t (*jit_entry_t)(proc_t *, uint64_t *, const uint8_t *);
+
+jit_stats_t jit_stats;
+bool jit_stale;
+
+static unsigned jit_threshold;
+static uint64_t barrier;    // 0 if none; address 0 never holds code.
+static jit_block_t *blocks[JIT_HASHSIZE];
+static uint8_t *cache, *cache_ptr, *cache_end;
+static uint8_t *epilogue;
+static jit_entry_t jit_enter;
+static pte_ptr_t *code_pages;   // Pages marked p_code, to unmark on a flush.
+static unsigned num_code_pages, max_code_pages;
+
+/*
+ * Emitting host code.
+ */
+
+#define EMIT(...) emit_bytes((const uint8_t []) {__VA_ARGS__}, sizeof((const uint8_t []) {__VA_ARGS__}))
+
+static inline void emit_bytes(const uint8_t *b, const size_t n) {
+    memcpy(cache_ptr, b, n);
+    cache_ptr += n;
+}
+
+static inline void emit32(const uint32_t v) {memcpy(cache_ptr, &v, 4); cache_ptr += 4;}
+static inline void emit64(const uint64_t v) {memcpy(cache_ptr, &v, 8); cache_ptr += 8;}
+
+// mov r, [rbx+disp]
+static void emit_load(const unsigned r, const int32_t disp) {EMIT(0x48, 0x8B, 0x83 | r << 3); emit32(disp);}
+
+// mov [rbx+disp], r
+static void emit_store(const unsigned r, const int32_t disp) {EMIT(0x48, 0x89, 0x83 | r << 3); emit32(disp);}
+
+// mov r, imm64
+static void emit_mov_imm(const unsigned r, const uint64_t v) {EMIT(0x48, 0xB8 | r); emit64(v);}
+
+// <op> dst, src for op = 0x01 add, 0x29 sub, 0x21 and, 0x09 or, 0x31 xor, 0x85 test
+static void emit_alu(const uint8_t op, const unsigned dst, const unsigned src) {EMIT(0x48, op, 0xC0 | src << 3 | dst);}
+
+// shl/shr/sar r, n for ext = 4, 5, 7
+static void emit_shift(const unsigned ext, const unsigned r, const unsigned n) {
+    if (n) EMIT(0x48, 0xC1, 0xC0 | ext << 3 | r, n);
+}
+
+static void emit_call(const void *fn) {emit_mov_imm(RAX, (uint64_t) fn); EMIT(0xFF, 0xD0);}
+
+// Jcc/JMP rel32 with the displacement left to patch_rel32.
+static uint8_t *emit_jcc(const uint8_t cc) {EMIT(0x0F, 0x80 | cc); emit32(0); return cache_ptr - 4;}
+static uint8_t *emit_jmp(void) {EMIT(0xE9); emit32(0); return cache_ptr - 4;}
+
+static void patch_rel32(uint8_t *at, const uint8_t *target) {
+    int32_t rel = (int32_t) (target - (at + 4));
+    memcpy(at, &rel, 4);
+}
+
+// Leave translated code, returning code in RAX.
+static void emit_leave(const uint64_t code) {
+    if (code) emit_mov_imm(RAX, code);
+    else EMIT(0x31, 0xC0); // xor eax, eax
+    patch_rel32(emit_jmp(), epilogue);
+}
+
+// Give back the budget of n instructions that will not run after all.
+static void emit_refund(const unsigned n) {
+    if (n) {EMIT(0x49, 0x81, 0xC4); emit32(n);} // add r12, n
+}
+
+static void emit_set_pc(const uint64_t pc) {
+    emit_mov_imm(RAX, pc);
+    emit_store(RAX, REG_OFF(R_PC));
+}
+
+/*
+ * Entry and exit sequences shared by all blocks:
+ *   uint64_t jit_enter(proc_t *proc, uint64_t *budget, const uint8_t *code)
+ * RSP is 16-byte aligned inside translated code, so helpers can be called
+ * directly.
+ */
+
+static void emit_trampolines(void) {
+    jit_enter = (jit_entry_t) cache_ptr;
+    EMIT(0x53, 0x41, 0x54, 0x41, 0x55);     // push rbx; push r12; push r13
+    EMIT(0x48, 0x89, 0xFB);                 // mov rbx, rdi
+    EMIT(0x49, 0x89, 0xF5);                 // mov r13, rsi
+    EMIT(0x4D, 0x8B, 0x65, 0x00);           // mov r12, [r13]
+    EMIT(0xFF, 0xE2);                       // jmp rdx
+    epilogue = cache_ptr;
+    EMIT(0x4D, 0x89, 0x65, 0x00);           // mov [r13], r12
+    EMIT(0x41, 0x5D, 0x41, 0x5C, 0x5B);     // pop r13; pop r12; pop rbx
+    EMIT(0xC3);                             // ret
+}
+
+/*
+ * Translating a block.
+ */
+
+typedef struct side_exit {
+    uint8_t *from;      // rel32 to point at the stub.
+    uint64_t pc;        // Guest PC to leave with.
+    unsigned refund;    // Instructions of the block not executed.
+    uint64_t code;      // JIT_EXIT_INTERP, or JIT_EXIT_LOOKUP if pc need not be interpreted.
+} side_exit_t;
+
+static side_exit_t side_exits[2 * JIT_MAX_BLOCK + 1];
+static unsigned num_side_exits;
+
+static void add_side_exit(uint8_t *from, const uint64_t pc, const unsigned refund, const uint64_t code) {
+    side_exits[num_side_exits++] = (side_exit_t) {from, pc, refund, code};
+}
+
+// Direct exit to target through a patchable stub.
+static void emit_exit_stub(jit_exit_t *e, const uint64_t target) {
+    e->stub = cache_ptr;
+    e->target = target;
+    emit_set_pc(target);
+    emit_leave((uint64_t) e);
+}
+
+// Compute the address of a load or store into RDI, first leaving the block
+// if it is reserved for devices (mmio_is_reserved).
+static void emit_address(const int32_t instr, const uint64_t pc, const unsigned refund) {
+    int64_t offset = ((int64_t) GETBF(instr, 12, 9) << 55) >> 55;
+    emit_load(RDI, REG_OFF(REG_SRC(GETBF(instr, 5, 5), true)));
+    if (offset) {EMIT(0x48, 0x81, 0xC7); emit32((uint32_t) offset);}   // add rdi, offset
+    EMIT(0x48, 0x8D, 0x47, 0xFF);                                       // lea rax, [rdi-1]
+    EMIT(0x48, 0x3D); emit32((uint32_t) (MMIO_BASE - 1));               // cmp rax, MMIO_BASE-1
+    add_side_exit(emit_jcc(X_AE), pc, refund, JIT_EXIT_INTERP);
+}
+
+// Mark the page holding pc as translated code.
+static void mark_code_page(const uint64_t pc) {
+    pte_ptr_t page = get_page(pc / PAGESIZE);
+    if (page->p_code) return;
+    if (num_code_pages == max_code_pages) {
+        max_code_pages = max_code_pages ? 2 * max_code_pages : 16;
+        code_pages = realloc(code_pages, max_code_pages * sizeof(pte_ptr_t));
+    }
+    code_pages[num_code_pages++] = page;
+    page->p_code = true;
+}
+
+// Record a flag-setting result in the lazy NZCV state, as common_writeback_alu_X_cc does.
+static void emit_set_cc(const opcode_t op) {
+    emit_store(RAX, PROC_OFF(cc_opnd1));
+    emit_store(RCX, PROC_OFF(cc_opnd2));
+    EMIT(0xC7, 0x83); emit32(PROC_OFF(cc_op)); emit32(op);       // mov dword [rbx+cc_op], op
+}
+
+// Host condition for a B.cond after a 64-bit SUBS, indexed by cond_t.
+static const uint8_t subs_cc[] = {0x4, 0x5, 0x3, 0x2, 0x8, 0x9, 0x0, 0x1, 0x7, 0x6, 0xD, 0xC, 0xF, 0xE};
+
+// The opcodes translate() has code for. A block ends before any other,
+// which the interpreter then runs; this includes all of the 32-bit forms.
+static inline bool translatable(const opcode_t op) {
+    switch (op) {
+        case OP_ADD_RI: case OP_ADDS_RR: case OP_SUBS_RR: case OP_ANDS_RR:
+        case OP_ADD_RR: case OP_SUB_RR: case OP_AND_RR: case OP_ORR_RR: case OP_EOR_RR:
+        case OP_MVN: case OP_UBFM: case OP_ASR: case OP_MOVZ: case OP_MOVK:
+        case OP_LDUR: case OP_LDURB: case OP_STUR: case OP_STURB: case OP_NOP:
+        case OP_B: case OP_BL: case OP_B_COND: case OP_RET:
+            return true;
+        default:
+            return false;
+    }
+}
+
+static bool translate(jit_block_t *b) {
+    uint64_t pc = b->pc;
+    unsigned n = 0;
+    int32_t words[JIT_MAX_BLOCK];
+    opcode_t ops[JIT_MAX_BLOCK];
+
+    // Find the extent of the block: up to and including the first control transfer.
+    for (; n < JIT_MAX_BLOCK; n++) {
+        if (n && pc + 4*n == barrier) break;
+        int32_t instr = mem_read_I(pc + 4*n);
+        opcode_t op = lookup_op(instr);
+        if (!translatable(op)) break;
+        if (OP_ASR == op && 0x3FU != GETBF(instr, 10, 6)) break;
+        words[n] = instr;
+        ops[n] = op;
+        if (OP_B == op || OP_BL == op || OP_B_COND == op || OP_RET == op) {n++; break;}
+    }
+    if (0 == n) return false;
+    mark_code_page(pc);
+    mark_code_page(pc + 4*(n-1));
+
+    uint8_t *start = cache_ptr, *bail;
+    opcode_t cc_setter = OP_NONE;
+    bool ended = false;
+    num_side_exits = 0;
+
+    // cmp r12, n; jb bail; sub r12, n
+    EMIT(0x49, 0x81, 0xFC); emit32(n);
+    bail = emit_jcc(X_B);
+    EMIT(0x49, 0x81, 0xEC); emit32(n);
+    add_side_exit(bail, pc, 0, JIT_EXIT_INTERP);
+
+    for (unsigned k = 0; k < n; k++, pc += 4) {
+        int32_t instr = words[k];
+        unsigned d = GETBF(instr, 0, 5), nn = GETBF(instr, 5, 5), m = GETBF(instr, 16, 5);
+        unsigned imm6 = GETBF(instr, 10, 6);
+        switch (ops[k]) {
+            case OP_ADD_RI: {
+                uint32_t imm = GETBF(instr, 10, 12) << (GETBF(instr, 22, 1) ? 12 : 0);
+                emit_load(RAX, REG_OFF(REG_SRC(nn, true)));
+                if (imm) {EMIT(0x48, 0x05); emit32(imm);}  // add rax, imm
+                emit_store(RAX, REG_OFF(REG_DST(d, true)));
+                break;
+            }
+            case OP_ADDS_RR: case OP_SUBS_RR: case OP_ANDS_RR:
+            case OP_ADD_RR: case OP_SUB_RR: case OP_AND_RR:
+            case OP_ORR_RR: case OP_EOR_RR: {
+                static const uint8_t alu[] = {
+                    [OP_ADDS_RR] = 0x01, [OP_SUBS_RR] = 0x29, [OP_ANDS_RR] = 0x21,
+                    [OP_ADD_RR] = 0x01, [OP_SUB_RR] = 0x29, [OP_AND_RR] = 0x21,
+                    [OP_ORR_RR] = 0x09, [OP_EOR_RR] = 0x31};
+                bool sets_cc = OP_ADDS_RR == ops[k] || OP_SUBS_RR == ops[k] || OP_ANDS_RR == ops[k];
+                emit_load(RAX, REG_OFF(REG_SRC(nn, false)));
+                emit_load(RCX, REG_OFF(REG_SRC(m, false)));
+                emit_shift(4, RCX, imm6);
+                if (sets_cc) emit_set_cc(ops[k]);
+                emit_alu(alu[ops[k]], RAX, RCX);
+                emit_store(RAX, REG_OFF(REG_DST(d, false)));
+                if (sets_cc) {
+                    emit_store(RAX, PROC_OFF(cc_res));
+                    cc_setter = ops[k];
+                }
+                break;
+            }
+            case OP_MVN:
+                emit_load(RAX, REG_OFF(REG_SRC(m, false)));
+                emit_shift(4, RAX, imm6);
+                EMIT(0x48, 0xF7, 0xD0); // not rax
+                emit_store(RAX, REG_OFF(REG_DST(d, false)));
+                break;
+            case OP_UBFM: {
+                unsigned immr = GETBF(instr, 16, 6), imms = imm6;
+                emit_load(RAX, REG_OFF(REG_SRC(nn, false)));
+                if (imms >= immr) {
+                    unsigned width = imms - immr + 1;
+                    emit_shift(5, RAX, immr);
+                    if (width < 64) {emit_mov_imm(RCX, (1ULL << width) - 1); emit_alu(0x21, RAX, RCX);}
+                } else {
+                    if (imms < 63) {emit_mov_imm(RCX, (1ULL << (imms + 1)) - 1); emit_alu(0x21, RAX, RCX);}
+                    emit_shift(4, RAX, 64 - immr);
+                }
+                emit_store(RAX, REG_OFF(REG_DST(d, false)));
+                break;
+            }
+            case OP_ASR:
+                emit_load(RAX, REG_OFF(REG_SRC(nn, false)));
+                emit_shift(7, RAX, GETBF(instr, 16, 6));
+                emit_store(RAX, REG_OFF(REG_DST(d, false)));
+                break;
+            case OP_MOVZ:
+                emit_mov_imm(RAX, (uint64_t) GETBF(instr, 5, 16) << (16 * GETBF(instr, 21, 2)));
+                emit_store(RAX, REG_OFF(REG_DST(d, false)));
+                break;
+            case OP_MOVK: {
+                unsigned shift = 16 * GETBF(instr, 21, 2);
+                emit_load(RAX, REG_OFF(REG_SRC(d, false)));
+                emit_mov_imm(RCX, ~(0xFFFFULL << shift));
+                emit_alu(0x21, RAX, RCX);
+                emit_mov_imm(RCX, (uint64_t) GETBF(instr, 5, 16) << shift);
+                emit_alu(0x09, RAX, RCX);
+                emit_store(RAX, REG_OFF(REG_DST(d, false)));
+                break;
+            }
+            case OP_LDUR: case OP_LDURB:
+                emit_address(instr, pc, n - k);
+                emit_call(OP_LDUR == ops[k] ? (void *) mem_read_L : (void *) mem_read_B);
+                if (OP_LDURB == ops[k]) EMIT(0x0F, 0xB6, 0xC0); // movzx eax, al
+                emit_store(RAX, REG_OFF(REG_DST(d, false)));
+                break;
+            case OP_STUR: case OP_STURB:
+                emit_address(instr, pc, n - k);
+                emit_load(RSI, REG_OFF(REG_SRC(d, false)));
+                emit_call(OP_STUR == ops[k] ? (void *) mem_write_L : (void *) mem_write_B);
+                emit_mov_imm(RAX, (uint64_t) &jit_stale);
+                EMIT(0x80, 0x38, 0x00);     // cmp byte [rax], 0
+                add_side_exit(emit_jcc(X_NE), pc + 4, n - k - 1, JIT_EXIT_LOOKUP);
+                break;
+            case OP_NOP:
+                break;
+            case OP_BL:
+                emit_mov_imm(RAX, pc + 4);
+                emit_store(RAX, REG_OFF(30));
+                // Fall through.
+            case OP_B: {
+                int64_t offset = ((int64_t) GETBF(instr, 0, 26) << 38) >> 36;
+                emit_exit_stub(&b->exits[0], pc + offset);
+                ended = true;
+                break;
+            }
+            case OP_B_COND: {
+                cond_t cond = GETBF(instr, 0, 4);
+                int64_t offset = ((int64_t) GETBF(instr, 5, 19) << 45) >> 43;
+                uint8_t *taken, *not_taken;
+                if (C_AL == cond || C_NV == cond) {
+                    emit_exit_stub(&b->exits[0], pc + offset);
+                    ended = true;
+                    break;
+                }
+                if (OP_SUBS_RR == cc_setter) {
+                    emit_load(RAX, PROC_OFF(cc_opnd1));
+                    EMIT(0x48, 0x3B, 0x83); emit32(PROC_OFF(cc_opnd2)); // cmp rax, [rbx+cc_opnd2]
+                    taken = emit_jcc(subs_cc[cond]);
+                } else {
+                    EMIT(0xBF); emit32(cond);   // mov edi, cond
+                    emit_call(cond_holds);
+                    EMIT(0x84, 0xC0);           // test al, al
+                    taken = emit_jcc(X_NE);
+                }
+                not_taken = emit_jmp();
+                patch_rel32(taken, cache_ptr);
+                emit_exit_stub(&b->exits[0], pc + offset);
+                patch_rel32(not_taken, cache_ptr);
+                emit_exit_stub(&b->exits[1], pc + 4);
+                ended = true;
+                break;
+            }
+            case OP_RET:
+                emit_load(RAX, REG_OFF(REG_SRC(nn, false)));
+                emit_store(RAX, REG_OFF(R_PC));
+                emit_leave(JIT_EXIT_LOOKUP);
+                ended = true;
+                break;
+            default:
+                assert(false);
+                break;
+        }
+    }
+    if (!ended) emit_exit_stub(&b->exits[0], pc);
+
+    for (unsigned i = 0; i < num_side_exits; i++) {
+        side_exit_t *s = side_exits + i;
+        patch_rel32(s->from, cache_ptr);
+        emit_refund(s->refund);
+        emit_set_pc(s->pc);
+        emit_leave(s->code);
+    }
+    assert(cache_ptr - start < JIT_BLOCK_RESERVE);
+
+    b->code = start;
+    b->len = n;
+    jit_stats.blocks++;
+    jit_stats.code_bytes += cache_ptr - start;
+    return true;
+}
+
+/*
+ * The block table, hashed on guest PC.
+ */
+
+static inline unsigned block_hash(const uint64_t pc) {return (pc >> 2) % JIT_HASHSIZE;}
+
+static jit_block_t *get_block(const uint64_t pc) {
+    unsigned h = block_hash(pc);
+    for (jit_block_t *b = blocks[h]; b != NULL; b = b->next)
+        if (pc == b->pc) return b;
+    jit_block_t *b = calloc(1, sizeof(jit_block_t));
+    b->pc = pc;
+    b->next = blocks[h];
+    blocks[h] = b;
+    return b;
+}
+
+// Throw away every translation. Only called from outside translated code.
+static void jit_flush(void) {
+    for (unsigned h = 0; h < JIT_HASHSIZE; h++) {
+        jit_block_t *b = blocks[h], *next;
+        for (; b != NULL; b = next) {
+            next = b->next;
+            free(b);
+        }
+        blocks[h] = NULL;
+    }
+    for (unsigned i = 0; i < num_code_pages; i++)
+        code_pages[i]->p_code = false;
+    num_code_pages = 0;
+    cache_ptr = cache;
+    emit_trampolines();
+    jit_stats.flushes++;
+    if (jit_stale) jit_stats.smc_flushes++;
+    jit_stale = false;
+}
+
+bool jit_init(const unsigned threshold) {
+    cache = mmap(NULL, JIT_CACHE_SIZE, PROT_READ | PROT_WRITE | PROT_EXEC,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (MAP_FAILED == cache) return false;
+    cache_ptr = cache;
+    cache_end = cache + JIT_CACHE_SIZE;
+    emit_trampolines();
+    jit_threshold = threshold;
+    return true;
+}
+
+void jit_set_barrier(const uint64_t pc) {
+    barrier = pc;
+}
+
+// Run the instruction at PC through the stages, as runElf does.
+static void interpret(void) {
+    instr_t insn;
+    memset(&insn, 0, sizeof(insn));
+    fetch_instr(&insn);
+    decode_instr(&insn);
+    execute_instr(&insn);
+    memory_instr(&insn);
+    wback_instr(&insn);
+    update_pc_instr(&insn);
+}
+
+/*
+ * Run translated code from the current PC for as long as possible, using
+ * at most budget instructions. Instructions that translated code cannot
+ * perform are interpreted here. Returns the number of guest instructions
+ * executed, possibly 0. On return the instruction at PC is to be run by
+ * the interpreter (unless PC is RET_FROM_MAIN_ADDR or the budget is used
+ * up), or PC is the barrier.
+ */
+
+uint64_t jit_run(const uint64_t budget) {
+    uint64_t left = budget, interpreted = 0;
+    uint64_t pc = guest.proc->regs[R_PC].xval;
+    jit_block_t *b;
+    jit_exit_t *from = NULL;
+
+    if (jit_stale) jit_flush();
+    b = get_block(pc);
+
+    for (;;) {
+        if (barrier == pc) break;
+        if (NULL == b->code) {
+            if (b->dead || ++b->count < jit_threshold) break;
+            if (cache_end - cache_ptr < JIT_BLOCK_RESERVE) {
+                jit_flush();
+                b = get_block(pc);
+                from = NULL;
+            }
+            if (!translate(b)) {b->dead = true; break;}
+        }
+        if (from) {
+            uint8_t *save = cache_ptr;
+            cache_ptr = from->stub;
+            patch_rel32(emit_jmp(), b->code);
+            cache_ptr = save;
+            jit_stats.chains++;
+        }
+        if (left < b->len) break;
+        jit_stats.entries++;
+        uint64_t ret = jit_enter(guest.proc, &left, b->code);
+        if (JIT_EXIT_INTERP == ret) {
+            if (0 == left) break;
+            num_instr += budget - left; // As the counter device expects.
+            interpret();
+            num_instr -= budget - left;
+            left--;
+            interpreted++;
+        }
+        pc = guest.proc->regs[R_PC].xval;
+        if (RET_FROM_MAIN_ADDR == pc) break;
+        if (jit_stale) {
+            jit_flush();
+            ret = JIT_EXIT_LOOKUP;  // The exit it came through is gone.
+        }
+        b = get_block(pc);
+        from = ret > JIT_EXIT_INTERP ? (jit_exit_t *) ret : NULL;
+    }
+    jit_stats.instrs += budget - left - interpreted;
+    return budget - left;
+}
@@ -25,7 +25,7 @@ static uint64_t seg_starts[] = {
 
 static uint8_t seg_prots[] = {0x0, 0x5, 0x6, 0x6, 0x5, 0x6, 0x0};
 
-extern machine_t guest;
+extern __thread machine_t guest;
 
 #define NUM_ADDR_BITS 64
 
@@ -37,12 +37,7 @@ void init_machine(char *name, unsigned word_size, byte_order_t code_order, byte_
     guest.data_order = data_order;
     guest.mode = MODE_KER;
 
-    guest.proc = malloc(sizeof(proc_t));
-    init_reg_file(&(guest.proc->GPR), "GPR", 31, 64);
-    // init_reg_file(&(guest.proc->FPR), "FPR", 32, 128);
-    init_reg(&(guest.proc->PC), "PC", -1, WVAR_64, (gpregval_t *) malloc(sizeof(gpregval_t)));
-    init_reg(&(guest.proc->SP), "SP", -1, WVAR_64, (gpregval_t *) malloc(sizeof(gpregval_t)));
-    init_reg(&(guest.proc->NZCV), "NZCV", -1, WVAR_4, (gpregval_t *) malloc(sizeof(gpregval_t)));
+    init_cores(1);
     
     guest.mem = malloc(sizeof(mem_t));
     guest.mem->max_addr = UINT_FAST64_MAX;
@@ -52,4 +47,16 @@ void init_machine(char *name, unsigned word_size, byte_order_t code_order, byte_
         guest.mem->seg_start_addr[i] = seg_starts[i];
         guest.mem->seg_prot[i] = seg_prots[i];
     }
+}
+
+/*
+ * Give the guest n processors, all reset, with the boot core current.
+ */
+
+void init_cores(const unsigned n) {
+    free(guest.procs);
+    guest.num_cores = n;
+    guest.procs = aligned_alloc(_Alignof(proc_t), n * sizeof(proc_t));
+    memset(guest.procs, 0, n * sizeof(proc_t));
+    guest.proc = guest.procs;
 }
\ No newline at end of file
@@ -18,20 +18,16 @@
 #include "mem.h"
 #include "ptable.h"
 #include "machine.h"
+#include "jit.h"
+#include "mmio.h"
 
-extern machine_t guest;
+extern __thread machine_t guest;
 
 const uint64_t NULL_ADDR = 0x0UL;
 const uint64_t IO_CHAR_ADDR = 0xFFFFFFFFFFFFFFFFUL;
 const uint64_t RET_FROM_MAIN_ADDR = 0xFFFFFFFFFFFFFFFFUL-4;
 
 
-static bool is_special_addr(const uint64_t addr) {
-    return ((NULL_ADDR == addr) || 
-            (IO_CHAR_ADDR == addr) || 
-            (RET_FROM_MAIN_ADDR == addr));
-}
-
 static byte_order_t get_byte_order(const uint64_t addr) {
     if ((guest.mem->seg_start_addr[TEXT_SEG] <= addr) && 
         (addr < guest.mem->seg_start_addr[DATA_SEG]))
@@ -71,31 +67,11 @@ static uint64_t _mem_read_BE(const uint64_t addr, const unsigned width) {
     return retval;
 }
 
-static uint64_t _mem_read_special(const uint64_t addr, const unsigned width) {
-    if (NULL_ADDR == addr) {
-        logging(LOG_FATAL, "Null pointer read attempt");
-        exit(EXIT_FAILURE);
-    }
-    if (IO_CHAR_ADDR == addr) {
-        uint8_t data8;
-        uint16_t data16;
-        uint32_t data32;
-        uint64_t data64;
-        switch (width) {
-            case 1: scanf("%c\n", &data8); return (char) (data8&0xFFU); break;
-            case 2: scanf("%hd\n", &data16); return (short) (data16 & 0xFFFFU); break;
-            case 4: scanf("%d\n", &data32); return (int) (data32 & 0xFFFFFFFFU); break;
-            case 8: scanf("%ld\n", &data64); return (long) data64; break;
-            default: assert(false); break;
-        }
-    }
-    if (RET_FROM_MAIN_ADDR == addr) {MISSING(); return 0;}
-    assert(false); return 0;
-}
-
 uint64_t _mem_read(const uint64_t addr, const unsigned width) {
-    if (is_special_addr(addr))
-        return _mem_read_special(addr, width);
+    if (mmio_is_reserved(addr)) {
+        mmio_dev_t *dev = mmio_find(addr);
+        if (NULL != dev) return dev->read(dev, addr - dev->base, width);
+    }
 
     byte_order_t b = get_byte_order(addr);
     switch (b) {
@@ -116,6 +92,7 @@ static write_ret_code_t _mem_write_byte(const uint64_t addr, const uint8_t data)
         page = add_page(pnum, 7);//FIX.
     }
     page->p_data[poff] = data;
+    if (page->p_code) jit_stale = true;
     //printf("%lx:%lx: %x\n", pnum, poff, data);
     return WRITE_SUCCESS;
 }
@@ -136,27 +113,11 @@ static write_ret_code_t _mem_write_BE(const uint64_t addr, const uint64_t data,
     return retval;
 }
 
-static write_ret_code_t _mem_write_special(const uint64_t addr, const uint64_t data, const unsigned width) {
-    if (NULL_ADDR == addr) {
-        logging(LOG_INFO, "Null pointer write attempt");
-        return WRITE_SUCCESS;
-    }
-    if (IO_CHAR_ADDR == addr) {
-        switch (width) {
-            case 1: putchar(data & 0xFFU); break;
-            case 2: printf("%hd\n", (short) (data & 0xFFFFU)); break;
-            case 4: printf("%d\n", (int) (data & 0xFFFFFFFFU)); break;
-            case 8: printf("%ld\n", (long) data); break;
-            default: assert(false); break;
-        }
-        return WRITE_SUCCESS;    
-    }
-    assert(false); return WRITE_SUCCESS;
-}
-
 write_ret_code_t _mem_write(const uint64_t addr, const uint64_t data, const unsigned width) {
-    if (is_special_addr(addr))
-        return _mem_write_special(addr, data, width);
+    if (mmio_is_reserved(addr)) {
+        mmio_dev_t *dev = mmio_find(addr);
+        if (NULL != dev) return dev->write(dev, addr - dev->base, data, width);
+    }
 
     byte_order_t b = get_byte_order(addr);
     switch (b) {
@@ -169,6 +130,53 @@ write_ret_code_t _mem_write(const uint64_t addr, const uint64_t data, const unsi
     }
 }
 
+/*
+ * Exclusive access. Each core's exclusive monitor (in its proc_t) holds
+ * the address, width and value of its last exclusive read, and its
+ * exclusive write is a compare-and-swap of the bytes against that value
+ * on the host. So the write fails if another core has changed them since,
+ * though not if it has changed them and changed them back, which
+ * load-linked/store-conditional code does not need to tell apart.
+ */
+
+static char *excl_bytes(const uint64_t addr, const unsigned width) {
+    if ((addr & (width - 1)) || mmio_is_reserved(addr) || L_ENDIAN != get_byte_order(addr)) {
+        logging(LOG_FATAL, "Exclusive access must be aligned and to little-endian memory");
+        exit(EXIT_FAILURE);
+    }
+    uint64_t pnum = addr / PAGESIZE;
+    pte_ptr_t page = get_page(pnum);
+    if (NULL == page)
+        page = add_page(pnum, get_prot_bits(addr));
+    return page->p_data + addr % PAGESIZE;
+}
+
+uint64_t mem_read_excl(const uint64_t addr, const unsigned width) {
+    proc_t *p = guest.proc;
+    char *bytes = excl_bytes(addr, width);
+    p->excl_addr = addr;
+    p->excl_width = width;
+    if (8 == width) p->excl_val = __atomic_load_n((uint64_t *) bytes, __ATOMIC_RELAXED);
+    else p->excl_val = __atomic_load_n((uint32_t *) bytes, __ATOMIC_RELAXED);
+    return p->excl_val;
+}
+
+bool mem_write_excl(const uint64_t addr, const uint64_t data, const unsigned width) {
+    proc_t *p = guest.proc;
+    char *bytes = excl_bytes(addr, width);
+    bool held = p->excl_width == width && p->excl_addr == addr;
+    p->excl_width = 0;
+    if (!held) return false;
+    if (8 == width) {
+        uint64_t expected = p->excl_val;
+        return __atomic_compare_exchange_n((uint64_t *) bytes, &expected, data, false, 
+                                           __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+    }
+    uint32_t expected = p->excl_val;
+    return __atomic_compare_exchange_n((uint32_t *) bytes, &expected, (uint32_t) data, false, 
+                                       __ATOMIC_RELAXED, __ATOMIC_RELAXED);
+}
+
 char      mem_read_B (const uint64_t addr) {return (char)      _mem_read(addr, 1);}
 short     mem_read_S (const uint64_t addr) {return (short)     _mem_read(addr, 2);}
 int       mem_read_I (const uint64_t addr) {return (int)       _mem_read(addr, 4);}
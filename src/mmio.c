@@ -0,0 +1,142 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * mmio.c - Registry of memory-mapped devices, and the built-in ones.
+ *
+ * mem.c hands every access to a reserved address (see mmio.h) to the
+ * device that claims it. The null, console and return-from-main addresses
+ * are devices like any other, registered from the start along with the
+ * counters and the region-of-interest markers (roi.c); further devices are
+ * added with mmio_register.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <time.h>
+#include "err_handler.h"
+#include "proc.h"
+#include "mmio.h"
+#include "roi.h"
+
+/*
+ * Null: catches dereferences of address 0.
+ */
+
+static uint64_t null_read(mmio_dev_t *dev, const uint64_t off, const unsigned width) {
+    logging(LOG_FATAL, "Null pointer read attempt");
+    exit(EXIT_FAILURE);
+}
+
+static mrc_t null_write(mmio_dev_t *dev, const uint64_t off, const uint64_t data, const unsigned width) {
+    logging(LOG_INFO, "Null pointer write attempt");
+    return WRITE_SUCCESS;
+}
+
+/*
+ * Console: a byte is read or written as a character, anything wider as a
+ * decimal integer on a line of its own.
+ */
+
+static uint64_t console_read(mmio_dev_t *dev, const uint64_t off, const unsigned width) {
+    uint8_t data8;
+    uint16_t data16;
+    uint32_t data32;
+    uint64_t data64;
+    switch (width) {
+        case 1: scanf("%c\n", &data8); return (char) (data8&0xFFU); break;
+        case 2: scanf("%hd\n", &data16); return (short) (data16 & 0xFFFFU); break;
+        case 4: scanf("%d\n", &data32); return (int) (data32 & 0xFFFFFFFFU); break;
+        case 8: scanf("%ld\n", &data64); return (long) data64; break;
+        default: assert(false); return 0;
+    }
+}
+
+static mrc_t console_write(mmio_dev_t *dev, const uint64_t off, const uint64_t data, const unsigned width) {
+    switch (width) {
+        case 1: putchar(data & 0xFFU); break;
+        case 2: printf("%hd\n", (short) (data & 0xFFFFU)); break;
+        case 4: printf("%d\n", (int) (data & 0xFFFFFFFFU)); break;
+        case 8: printf("%ld\n", (long) data); break;
+        default: assert(false); break;
+    }
+    return WRITE_SUCCESS;
+}
+
+/*
+ * Return from main: only ever a branch target.
+ */
+
+static uint64_t ret_read(mmio_dev_t *dev, const uint64_t off, const unsigned width) {
+    MISSING();
+    return 0;
+}
+
+static mrc_t ret_write(mmio_dev_t *dev, const uint64_t off, const uint64_t data, const unsigned width) {
+    assert(false);
+    return WRITE_SUCCESS;
+}
+
+/*
+ * Counters. num_instr is kept current up to the instruction doing the
+ * read, including when it runs on behalf of the JIT.
+ */
+
+static uint64_t counters_read(mmio_dev_t *dev, const uint64_t off, const unsigned width) {
+    struct timespec ts;
+    switch (off) {
+        case MMIO_CTR_INSTRET:
+        case MMIO_CTR_CYCLES:
+            return num_instr;
+        case MMIO_CTR_HOST_NS:
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+        default:
+            return 0;
+    }
+}
+
+static mrc_t counters_write(mmio_dev_t *dev, const uint64_t off, const uint64_t data, const unsigned width) {
+    return WRITE_SUCCESS;
+}
+
+// The first three sit at NULL_ADDR, IO_CHAR_ADDR and RET_FROM_MAIN_ADDR.
+static mmio_dev_t devs[MMIO_MAX_DEVS] = {
+    {"null",     0x0ULL,                    1,             null_read,     null_write,     NULL},
+    {"console",  0xFFFFFFFFFFFFFFFFULL,     1,             console_read,  console_write,  NULL},
+    {"ret",      0xFFFFFFFFFFFFFFFFULL - 4, 1,             ret_read,      ret_write,      NULL},
+    {"counters", MMIO_COUNTERS,             MMIO_CTR_SIZE, counters_read, counters_write, NULL},
+    {"roi",      MMIO_ROI,                  MMIO_ROI_SIZE, roi_read,      roi_write,      NULL},
+};
+static unsigned num_devs = 5;
+
+/*
+ * Add a device. It must lie within the reserved region and not overlap
+ * one already there. The table holds a copy of *dev.
+ */
+
+bool mmio_register(const mmio_dev_t *dev) {
+    uint64_t last = dev->base + dev->size - 1;
+    if (MMIO_MAX_DEVS == num_devs || 0 == dev->size || last < dev->base) return false;
+    if (!mmio_is_reserved(dev->base) || !mmio_is_reserved(last) || (0 == dev->base && dev->size > 1)) return false;
+    if (NULL == dev->read || NULL == dev->write) return false;
+    for (unsigned i = 0; i < num_devs; i++)
+        if (dev->base <= devs[i].base + devs[i].size - 1 && devs[i].base <= last) return false;
+    devs[num_devs++] = *dev;
+    return true;
+}
+
+/*
+ * The device that claims addr, or NULL. Only called for reserved addresses.
+ */
+
+mmio_dev_t *mmio_find(const uint64_t addr) {
+    for (unsigned i = 0; i < num_devs; i++)
+        if (addr - devs[i].base < devs[i].size) return devs + i;
+    return NULL;
+}
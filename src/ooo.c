@@ -0,0 +1,274 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * ooo.c - Out-of-order core timing model.
+ *
+ * Each record is scheduled once, as it arrives, against the times already
+ * computed for older instructions. In-order resources need only the times
+ * of the instruction that last held the entry: a reorder buffer of n
+ * entries has room for instruction i once instruction i - n has retired,
+ * so each such structure is a ring of times. The issue queue is freed out
+ * of order and is kept as a heap of issue times instead. Issue slots are
+ * counted per cycle in a calendar that wraps around every OOO_CAL_SIZE
+ * cycles; an instruction issuing further ahead of dispatch than that may
+ * share a slot it should not.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "ooo.h"
+
+static fu_class_t fu_class(const opcode_t op) {
+    switch (op) {
+        case OP_LDURB: case OP_LDUR: case OP_LDUR_W: case OP_LDXR: case OP_LDXR_W:
+            return FU_LOAD;
+        case OP_STURB: case OP_STUR: case OP_STUR_W: case OP_STXR: case OP_STXR_W:
+            return FU_STORE;
+        case OP_B: case OP_B_COND: case OP_BL: case OP_RET:
+            return FU_BRANCH;
+        default:
+            return FU_ALU;
+    }
+}
+
+static bool sets_flags(const opcode_t op) {
+    switch (op) {
+        case OP_ADDS_RR: case OP_SUBS_RR: case OP_ANDS_RR:
+        case OP_ADDS_RR_W: case OP_SUBS_RR_W: case OP_ANDS_RR_W:
+            return true;
+        default:
+            return false;
+    }
+}
+
+/*
+ * Set up an empty pipeline. The caches, the branch predictor, the DRAM
+ * and the TLBs are the caller's to initialize. Returns false if the parameters are
+ * unusable.
+ */
+
+bool ooo_init(ooo_t *o, const ooo_params_t *p) {
+    memset(o, 0, sizeof(*o));
+    if (0 == p->fetch || 0 == p->issue || 0 == p->retire || 0 == p->ports) return false;
+    if (p->fetch > OOO_MAX_WIDTH || p->issue > OOO_MAX_WIDTH || p->retire > OOO_MAX_WIDTH) return false;
+    if (0 == p->rob || 0 == p->iq || 0 == p->lsq || p->prf <= OOO_ARCH_REGS) return false;
+    o->p = *p;
+    o->fq_size = p->fetch * OOO_FETCH_BUF;
+    o->ren_size = p->prf - OOO_ARCH_REGS;
+    o->fq = calloc(o->fq_size, sizeof(uint64_t));
+    o->rob_q = calloc(p->rob, sizeof(uint64_t));
+    o->ren_q = calloc(o->ren_size, sizeof(uint64_t));
+    o->lsq_q = calloc(p->lsq, sizeof(ooo_mem_op_t));
+    o->iq_heap = calloc(p->iq, sizeof(uint64_t));
+    o->cal = calloc(OOO_CAL_SIZE, sizeof(ooo_slot_t));
+    return true;
+}
+
+void ooo_free(ooo_t *o) {
+    free(o->fq);
+    free(o->rob_q);
+    free(o->ren_q);
+    free(o->lsq_q);
+    free(o->iq_heap);
+    free(o->cal);
+    o->fq = o->rob_q = o->ren_q = o->iq_heap = NULL;
+    o->lsq_q = NULL;
+    o->cal = NULL;
+}
+
+void ooo_reset_stats(ooo_t *o) {
+    o->cycles = o->rob_occ = o->iq_occ = o->lsq_occ = 0;
+    o->stall_rob = o->stall_iq = o->stall_prf = o->stall_lsq = 0;
+    o->forwards = 0;
+}
+
+void ooo_add_stats(ooo_t *sum, const ooo_t *o) {
+    sum->cycles += o->cycles;
+    sum->rob_occ += o->rob_occ;
+    sum->iq_occ += o->iq_occ;
+    sum->lsq_occ += o->lsq_occ;
+    sum->stall_rob += o->stall_rob;
+    sum->stall_iq += o->stall_iq;
+    sum->stall_prf += o->stall_prf;
+    sum->stall_lsq += o->stall_lsq;
+    sum->forwards += o->forwards;
+}
+
+/*
+ * Issue-queue heap.
+ */
+
+static void heap_pop(ooo_t *o) {
+    uint64_t *h = o->iq_heap, last = h[--o->iq_n];
+    unsigned i = 0;
+    for (;;) {
+        unsigned c = 2 * i + 1;
+        if (c >= o->iq_n) break;
+        if (c + 1 < o->iq_n && h[c + 1] < h[c]) c++;
+        if (last <= h[c]) break;
+        h[i] = h[c];
+        i = c;
+    }
+    if (o->iq_n) h[i] = last;
+}
+
+static void heap_push(ooo_t *o, const uint64_t t) {
+    uint64_t *h = o->iq_heap;
+    unsigned i = o->iq_n++;
+    while (i && h[(i - 1) / 2] > t) {
+        h[i] = h[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+    h[i] = t;
+}
+
+// Instructions that have issued by cycle t have left the queue.
+static void heap_drain(ooo_t *o, const uint64_t t) {
+    while (o->iq_n && o->iq_heap[0] <= t) heap_pop(o);
+}
+
+// Hold t back until a resource frees up at cycle until, counting the delay.
+static inline uint64_t wait_for(const uint64_t t, const uint64_t until, uint64_t *stall) {
+    if (until <= t) return t;
+    *stall += until - t;
+    return until;
+}
+
+static inline uint64_t max64(const uint64_t a, const uint64_t b) {return a > b ? a : b;}
+
+/*
+ * The first cycle from t with an issue slot free, and a memory port if
+ * needed; the slot is taken.
+ */
+
+static uint64_t take_issue_slot(ooo_t *o, uint64_t t, const bool mem) {
+    for (;; t++) {
+        ooo_slot_t *s = o->cal + (t & (OOO_CAL_SIZE - 1));
+        if (s->cycle != t) {
+            s->cycle = t;
+            s->issued = s->mem = 0;
+        }
+        if (s->issued < o->p.issue && (!mem || s->mem < o->p.ports)) {
+            s->issued++;
+            s->mem += mem;
+            return t;
+        }
+    }
+}
+
+/*
+ * The youngest store still queued at cycle t that overlaps [addr, addr +
+ * width), or NULL.
+ */
+
+static const ooo_mem_op_t *older_store(const ooo_t *o, const uint64_t addr, const unsigned width,
+                                       const uint64_t t) {
+    for (unsigned k = 1; k <= o->p.lsq; k++) {
+        const ooo_mem_op_t *m = o->lsq_q + (o->lsq_head + o->p.lsq - k) % o->p.lsq;
+        if (m->is_store && m->retire > t && m->addr < addr + width && addr < m->addr + m->width)
+            return m;
+    }
+    return NULL;
+}
+
+void ooo_consume(ooo_t *o, const trace_rec_t *rec) {
+    const ooo_params_t *p = &o->p;
+    fu_class_t fu = fu_class(rec->op);
+    bool mem = 0 != rec->mem_width;
+    bool writes_flags = sets_flags(rec->op);
+    bool writes = TRACE_NO_REG != rec->dst || writes_flags;
+
+    // Fetch, in order, no sooner than there is room in the fetch buffer.
+    uint64_t fetch = max64(max64(o->fetch_cycle, o->redirect), o->fq[o->fq_head]);
+    if (fetch == o->fetch_cycle && o->fetch_n == p->fetch) fetch++;
+    if (tlb_enabled(&o->tlb)) fetch += tlb_translate(&o->tlb, rec->pc, true);
+    if (!cache_access(&o->l1i, rec->pc, 4, false))
+        fetch += p->miss_lat + dram_fill(&o->dram, &o->l1i, o->l1i.writebacks, rec->pc, fetch + p->miss_lat);
+    if (fetch != o->fetch_cycle) {
+        o->fetch_cycle = fetch;
+        o->fetch_n = 0;
+    }
+    o->fetch_n++;
+
+    // Dispatch, in order, once every structure has room.
+    uint64_t disp = max64(fetch + 1, o->disp_cycle);
+    disp = wait_for(disp, o->rob_q[o->rob_head], &o->stall_rob);
+    if (writes) disp = wait_for(disp, o->ren_q[o->ren_head], &o->stall_prf);
+    if (mem) disp = wait_for(disp, o->lsq_q[o->lsq_head].retire, &o->stall_lsq);
+    heap_drain(o, disp);
+    if (o->iq_n == p->iq) {
+        disp = wait_for(disp, o->iq_heap[0], &o->stall_iq);
+        heap_drain(o, disp);
+    }
+    if (disp == o->disp_cycle && o->disp_n == p->fetch) {
+        disp++;
+        heap_drain(o, disp);
+    }
+    if (disp != o->disp_cycle) {
+        o->disp_cycle = disp;
+        o->disp_n = 0;
+    }
+    o->disp_n++;
+
+    // Issue, out of order, once the operands are ready.
+    uint64_t ready = disp + 1;
+    if (TRACE_NO_REG != rec->src1) ready = max64(ready, o->reg_ready[rec->src1]);
+    if (TRACE_NO_REG != rec->src2) ready = max64(ready, o->reg_ready[rec->src2]);
+    if (OP_B_COND == rec->op) ready = max64(ready, o->reg_ready[OOO_NZCV]);
+    const ooo_mem_op_t *st = NULL;
+    bool forward = false;
+    if (FU_LOAD == fu && NULL != (st = older_store(o, rec->mem_addr, rec->mem_width, disp))) {
+        forward = st->addr <= rec->mem_addr && rec->mem_addr + rec->mem_width <= st->addr + st->width;
+        ready = max64(ready, forward ? st->ready : st->retire);
+    }
+    uint64_t issue = take_issue_slot(o, ready, mem);
+    heap_push(o, issue);
+
+    // Complete.
+    uint64_t lat = p->lat[fu], wb = o->l1d.writebacks;
+    if (FU_LOAD == fu) {
+        if (tlb_enabled(&o->tlb)) lat += tlb_translate(&o->tlb, rec->mem_addr, false);
+        if (forward) o->forwards++;
+        else if (!cache_access(&o->l1d, rec->mem_addr, rec->mem_width, false))
+            lat += p->miss_lat + dram_fill(&o->dram, &o->l1d, wb, rec->mem_addr, issue + p->miss_lat);
+    }
+    uint64_t done = issue + lat;
+    if (TRACE_NO_REG != rec->dst) o->reg_ready[rec->dst] = done;
+    if (writes_flags) o->reg_ready[OOO_NZCV] = done;
+    if (OP_B_COND == rec->op && !bpred_update(&o->bp, rec->pc, rec->taken))
+        o->redirect = done + p->mispredict_pen;
+    else if (rec->taken) o->redirect = fetch + 1 + p->taken_pen;
+
+    // Retire, in order.
+    uint64_t retire = max64(done, o->retire_cycle);
+    if (retire == o->retire_cycle && o->retire_n == p->retire) retire++;
+    if (FU_STORE == fu && tlb_enabled(&o->tlb)) tlb_translate(&o->tlb, rec->mem_addr, false);
+    if (FU_STORE == fu && !cache_access(&o->l1d, rec->mem_addr, rec->mem_width, true))
+        dram_fill(&o->dram, &o->l1d, wb, rec->mem_addr, retire + p->miss_lat);
+    if (retire != o->retire_cycle) {
+        o->cycles += retire - o->retire_cycle;
+        o->retire_cycle = retire;
+        o->retire_n = 0;
+    }
+    o->retire_n++;
+
+    // Hand the entries on to the instructions that will reuse them.
+    o->fq[o->fq_head] = disp;
+    o->fq_head = (o->fq_head + 1) % o->fq_size;
+    o->rob_q[o->rob_head] = retire;
+    o->rob_head = (o->rob_head + 1) % p->rob;
+    if (writes) {
+        o->ren_q[o->ren_head] = retire;
+        o->ren_head = (o->ren_head + 1) % o->ren_size;
+    }
+    if (mem) {
+        o->lsq_q[o->lsq_head] = (ooo_mem_op_t) {rec->mem_addr, done, retire, rec->mem_width, rec->is_store};
+        o->lsq_head = (o->lsq_head + 1) % p->lsq;
+        o->lsq_occ += retire - disp;
+    }
+    o->rob_occ += retire - disp;
+    o->iq_occ += issue - disp;
+}
@@ -10,31 +10,206 @@
  **************************************************************************/ 
 
 #include "archsim.h"
+#include "util.h"
 
-extern machine_t guest;
+extern __thread machine_t guest;
+
+static char printbuf[BUF_LEN];
+static double run_start;
+__thread uint64_t num_instr;
+
+/*
+ * Close the trace and report its size and cost. Registered with atexit so
+ * that runs ending in HLT still get a complete trace.
+ */
+
+static void finish_trace(void) {
+    trace_stats_t ts;
+    if (!trace_is_open()) return;
+    trace_close(&ts);
+    double run_secs = now_secs() - run_start;
+    sprintf(printbuf, "Trace: %lu instrs, %lu bytes, %.2f bytes/instr", 
+            ts.num_recs, ts.num_bytes, ratio(ts.num_bytes, ts.num_recs));
+    logging(LOG_INFO, printbuf);
+    sprintf(printbuf, "Trace: %.3fs of %.3fs run, slowdown %.2fx", 
+            ts.secs, run_secs, run_secs > ts.secs ? run_secs / (run_secs - ts.secs) : 0.0);
+    logging(LOG_INFO, printbuf);
+}
+
+/*
+ * Report how much of the dynamic instruction stream ran as fused groups.
+ * Registered with atexit so that runs ending in HLT are reported too.
+ */
+
+static void finish_fusion(void) {
+    static bool reported = false;
+    uint64_t fused = 0;
+    if (reported) return;
+    reported = true;
+    for (int k = 0; k < FUSE_NUM_KINDS; k++) {
+        if (!fuse_stats.groups[k]) continue;
+        sprintf(printbuf, "Fusion: %-14s %lu groups, %lu instrs", 
+                fuse_name(k), fuse_stats.groups[k], fuse_stats.instrs[k]);
+        logging(LOG_INFO, printbuf);
+        fused += fuse_stats.instrs[k];
+    }
+    sprintf(printbuf, "Fusion: %lu of %lu instrs fused (%.1f%%)", 
+            fused, num_instr, num_instr ? 100.0 * fused / num_instr : 0.0);
+    logging(LOG_INFO, printbuf);
+}
+
+/*
+ * Report what the translation tier did. Registered with atexit, as above.
+ */
+
+static void finish_jit(void) {
+    static bool reported = false;
+    if (reported) return;
+    reported = true;
+    sprintf(printbuf, "JIT: %lu of %lu instrs translated (%.1f%%)", 
+            jit_stats.instrs, num_instr, num_instr ? 100.0 * jit_stats.instrs / num_instr : 0.0);
+    logging(LOG_INFO, printbuf);
+    sprintf(printbuf, "JIT: %lu blocks, %lu bytes, %lu entries, %lu chains, %lu flushes (%lu for stores to code)", 
+            jit_stats.blocks, jit_stats.code_bytes, jit_stats.entries, jit_stats.chains, jit_stats.flushes,
+            jit_stats.smc_flushes);
+    logging(LOG_INFO, printbuf);
+}
 
 int runElf(const uint64_t entry) {
     logging(LOG_INFO, "Running ELF executable");
-    guest.proc->PC.bits->xval = entry;
-    guest.proc->SP.bits->xval = guest.mem->seg_start_addr[KERNEL_SEG]-8;
-    guest.proc->NZCV.bits->ccval = PACK_CC(0, 1, 0, 0);
-    guest.proc->GPR.bits[30].xval = RET_FROM_MAIN_ADDR;
+    if (guest_cores || coh_config) return smp_run(entry);
+    guest.proc->regs[R_PC].xval = entry;
+    guest.proc->regs[R_SP].xval = guest.mem->seg_start_addr[KERNEL_SEG]-8;
+    guest.proc->regs[R_NZCV].ccval = PACK_CC(0, 1, 0, 0);
+    guest.proc->regs[30].xval = RET_FROM_MAIN_ADDR;
+    if (trace_file) {
+        if (!trace_open(trace_file, entry)) {
+            logging(LOG_FATAL, "Cannot open trace file");
+            exit(EXIT_FAILURE);
+        }
+        atexit(finish_trace);
+    }
+    if (bbv_file) {
+        if (!bbv_open(bbv_file, bbv_interval)) {
+            logging(LOG_FATAL, "Cannot open BBV file");
+            exit(EXIT_FAILURE);
+        }
+        atexit(bbv_close);
+    }
+    // Fast-forward first if asked to; the detailed phase needs one trace
+    // record or model update per instruction, so it neither fuses nor
+    // translates. A sampled run stays on the fast path, leaving the
+    // detailed phases to the samples it forks.
+    uint64_t stop_pc = 0;
+    if (ff_until && 0 == (stop_pc = detail_stop_pc(ff_until))) {
+        logging(LOG_FATAL, "Cannot find fast-forward target");
+        exit(EXIT_FAILURE);
+    }
+    bool sampled = sample_period;
+    if (sampled && (trace_file || bbv_file || 0 == detail_num_models())) {
+        logging(LOG_FATAL, "Sampling needs -m, and excludes -t and -V");
+        exit(EXIT_FAILURE);
+    }
+    bool ff = ff_instrs || stop_pc;
+    bool per_instr = trace_file || detail_num_models();
+    bool detailed = per_instr && !ff && !sampled;
+    bool fast = !per_instr || ff || sampled; // There is a fast phase.
+    bool fusion = !no_fusion && fast;
+    if (fusion) atexit(finish_fusion);
+    bool jit = jit_threshold && fast && !bbv_file; // BBVs need every block entry.
+    if (jit) {
+        if (!jit_init(jit_threshold)) {
+            logging(LOG_FATAL, "Cannot allocate JIT code cache");
+            exit(EXIT_FAILURE);
+        }
+        jit_set_barrier(stop_pc);
+        atexit(finish_jit);
+    }
+    atexit(detail_finish);
+    if (sampled) {
+        if (!sample_init(sample_jobs)) {
+            logging(LOG_FATAL, "Cannot set up sampling");
+            exit(EXIT_FAILURE);
+        }
+        atexit(sample_finish); // Runs before detail_finish.
+    }
+    bool in_sample = false;
+    bool at_head = true; // PC may start a basic block.
+    uint64_t head = 0;   // Where the current basic block was entered.
+    run_start = now_secs();
+    num_instr = 0;
+    roi_init(!roi_only);
+    atexit(roi_finish);
 
 #ifdef DEBUG
     printf("\n%s%s   Addr      Instr       Op  \tCond\tDest\tSrc1\tSrc2\tImmval   \t\tShift\tWback\tPostindex%s\n", 
            ANSI_BOLD, ANSI_COLOR_RED, ANSI_RESET);
 #endif
-    unsigned int num_instr = 0;
+    uint64_t budget = max_num_instr ? max_num_instr : UINT64_MAX;
+    uint64_t limit = ff_instrs && ff_instrs < budget ? ff_instrs : budget;
+    uint64_t next_sample = sampled && !ff ? 0 : UINT64_MAX;
     do {
+        uint64_t pc = guest.proc->regs[R_PC].xval;
+        if (ff && (num_instr >= limit || pc == stop_pc)) {
+            ff = false;
+            limit = budget;
+            if (sampled) next_sample = num_instr;
+            else {
+                detailed = per_instr;
+                detail_begin(warmup_instrs);
+            }
+        }
+        if (num_instr >= next_sample) {
+            next_sample += sample_period;
+            if (sample_fork()) {
+                in_sample = detailed = true;
+                next_sample = UINT64_MAX;
+                if (budget - num_instr > warmup_instrs + sample_len) budget = num_instr + warmup_instrs + sample_len;
+                detail_begin(warmup_instrs);
+            }
+            limit = next_sample < budget ? next_sample : budget;
+        }
+        if (jit && at_head && !detailed) {
+            uint64_t n = jit_run(limit - num_instr);
+            num_instr += n;
+            at_head = false; // The instruction at PC is to be interpreted.
+            if (n) continue;
+        }
         instr_t *insn = calloc(1, sizeof(instr_t));
+        unsigned nfused;
+        uint64_t fuse_budget = limit - num_instr;
+        if (ff && stop_pc > pc && (stop_pc - pc) / 4 < fuse_budget) fuse_budget = (stop_pc - pc) / 4;
+        if (bbv_file && bbv_room() < fuse_budget) fuse_budget = bbv_room();
+        if (at_head) head = pc;
         fetch_instr(insn); show_instr(insn, S_FETCH);
         decode_instr(insn); show_instr(insn, S_DECODE);
+        if (fusion && !detailed && (nfused = fuse_exec(insn, fuse_budget))) {
+            free(insn);
+            if (bbv_file) bbv_count(head, nfused);
+            num_instr += nfused;
+            at_head = guest.proc->regs[R_PC].xval != pc + 4*nfused;
+            continue;
+        }
         execute_instr(insn); show_instr(insn, S_EXECUTE);
         memory_instr(insn); show_instr(insn, S_MEMORY);
         wback_instr(insn); show_instr(insn, S_WBACK);
         update_pc_instr(insn); show_instr(insn, S_UPDATE_PC);
+        if (detailed) {
+            if (trace_file && roi_active) trace_instr(insn, pc, guest.proc->regs[R_PC].xval);
+            detail_retire(insn, pc, guest.proc->regs[R_PC].xval);
+        }
         free(insn);
+        if (bbv_file) bbv_count(head, 1);
         num_instr++;
-    } while (guest.proc->PC.bits->xval != RET_FROM_MAIN_ADDR && num_instr < MAX_NUM_INSTR);
+        at_head = guest.proc->regs[R_PC].xval != pc + 4;
+    } while (guest.proc->regs[R_PC].xval != RET_FROM_MAIN_ADDR && num_instr < budget);
+    if (in_sample) sample_child_exit();
+    roi_finish();
+    sample_finish();
+    detail_finish();
+    bbv_close();
+    finish_trace();
+    if (fusion) finish_fusion();
+    if (jit) finish_jit();
     return EXIT_SUCCESS;
 }
\ No newline at end of file
@@ -5,15 +5,23 @@
  * 
  * ptable.c - Module for simple demand-paged virtual memory.
  * 
+ * Guest cores on different host threads share the table. Lookups take no
+ * lock: a page is published at the head of its chain, fully built, with a
+ * release store that get_page's acquire load pairs with, and pages are
+ * never removed. Adding one is serialized by a lock, under which the chain
+ * is searched again so that two cores touching a new page get the same one.
+ * 
  * Copyright (c) 2022. S. Chatterjee. All rights reserved.
  * May not be used, modified, or copied without permission.
  **************************************************************************/ 
 
 #include <stdlib.h>
+#include <pthread.h>
 #include "ptable.h"
 
 #define HASHSIZE 128
 static pte_ptr_t ptable[HASHSIZE];
+static pthread_mutex_t ptable_lock = PTHREAD_MUTEX_INITIALIZER;
 
 static unsigned long ptable_hash(const uint64_t pnum) {
     unsigned long h = 0, high;
@@ -30,7 +38,7 @@ static unsigned long ptable_hash(const uint64_t pnum) {
 
 pte_ptr_t get_page(const uint64_t pnum) {
     unsigned long phash = ptable_hash(pnum);
-    pte_ptr_t p = ptable[phash];
+    pte_ptr_t p = __atomic_load_n(&ptable[phash], __ATOMIC_ACQUIRE);
     for (; p != NULL; p = p->p_next) {
         if (pnum == p->p_num) return p;
     }
@@ -38,12 +46,18 @@ pte_ptr_t get_page(const uint64_t pnum) {
 }
 
 pte_ptr_t add_page(const uint64_t num, const uint8_t prot) {
-    pte_ptr_t npage = malloc(sizeof(pte_t));
-    npage->p_num = num;
-    npage->p_prot = prot;
-    npage->p_data = calloc(PAGESIZE,sizeof(char));
     unsigned long phash = ptable_hash(num);
-    npage->p_next = ptable[phash];
-    ptable[phash] = npage;
+    pthread_mutex_lock(&ptable_lock);
+    pte_ptr_t npage = get_page(num);
+    if (NULL == npage) {
+        npage = malloc(sizeof(pte_t));
+        npage->p_num = num;
+        npage->p_prot = prot;
+        npage->p_data = calloc(PAGESIZE,sizeof(char));
+        npage->p_code = false;
+        npage->p_next = ptable[phash];
+        __atomic_store_n(&ptable[phash], npage, __ATOMIC_RELEASE);
+    }
+    pthread_mutex_unlock(&ptable_lock);
     return npage;
 }
\ No newline at end of file
@@ -0,0 +1,111 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * roi.c - Guest-marked regions of interest.
+ *
+ * Statistics for the regions are kept from snapshots of num_instr and the
+ * host clock taken at each marker, so collecting them costs nothing per
+ * instruction, whether the instructions are interpreted, fused or run as
+ * translated code.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "archsim.h"
+#include "util.h"
+
+bool roi_active = true;
+
+static char printbuf[BUF_LEN];
+static roi_stats_t stats;
+static uint64_t start_instr;    // num_instr when the open region started.
+static double start_secs;
+static bool marked;             // The guest has used a marker.
+static bool finished;
+
+/*
+ * Begin a run, collecting from the start if active.
+ */
+
+void roi_init(const bool active) {
+    memset(&stats, 0, sizeof(stats));
+    roi_active = marked = finished = false;
+    if (active) roi_start();
+}
+
+void roi_start(void) {
+    if (roi_active) return;
+    roi_active = true;
+    stats.regions++;
+    start_instr = num_instr;
+    start_secs = now_secs();
+}
+
+void roi_stop(void) {
+    if (!roi_active) return;
+    stats.instrs += num_instr - start_instr;
+    stats.secs += now_secs() - start_secs;
+    roi_active = false;
+}
+
+void roi_reset(void) {
+    memset(&stats, 0, sizeof(stats));
+    if (!roi_active) return;
+    stats.regions = 1;
+    start_instr = num_instr;
+    start_secs = now_secs();
+}
+
+/*
+ * The statistics so far, including the region still open.
+ */
+
+roi_stats_t roi_get_stats(void) {
+    roi_stats_t s = stats;
+    if (roi_active) {
+        s.instrs += num_instr - start_instr;
+        s.secs += now_secs() - start_secs;
+    }
+    return s;
+}
+
+void roi_dump(const char *what) {
+    roi_stats_t s = roi_get_stats();
+    sprintf(printbuf, "ROI %s: %u regions, %lu instrs, %.3fs, %.2f MIPS", what,
+            s.regions, s.instrs, s.secs, s.secs > 0 ? s.instrs / s.secs * 1e-6 : 0.0);
+    logging(LOG_INFO, printbuf);
+}
+
+/*
+ * End of run: report the totals if the guest marked regions of interest
+ * or collection did not start with the run. Safe to call more than once,
+ * so that it can also be registered with atexit for runs ending in HLT.
+ */
+
+void roi_finish(void) {
+    if (finished) return;
+    finished = true;
+    bool report = marked || 1 != stats.regions;
+    roi_stop();
+    if (report) roi_dump("total");
+}
+
+uint64_t roi_read(mmio_dev_t *dev, const uint64_t off, const unsigned width) {
+    return roi_active;
+}
+
+mrc_t roi_write(mmio_dev_t *dev, const uint64_t off, const uint64_t data, const unsigned width) {
+    marked = true;
+    switch (off) {
+        case MMIO_ROI_RESET: roi_reset(); break;
+        case MMIO_ROI_START: roi_start(); break;
+        case MMIO_ROI_STOP:  roi_stop(); break;
+        case MMIO_ROI_DUMP:  roi_dump("dump"); break;
+        default: break;
+    }
+    return WRITE_SUCCESS;
+}
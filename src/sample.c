@@ -0,0 +1,181 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * sample.c - Sampled simulation, one forked process per sample.
+ *
+ * The emulator keeps the guest in globals, so samples run in processes
+ * rather than threads: fork gives each one a private, copy-on-write
+ * checkpoint of the whole machine at no cost to the parent. A child sends
+ * its models back as raw timing_model_t structures, of which the parent
+ * reads only the counters (see timing_model_add_stats).
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <math.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/wait.h>
+#include "archsim.h"
+#include "timing.h"
+#include "util.h"
+
+typedef struct sample_job {
+    pid_t       pid;
+    int         fd;         // Read end of the pipe from the child.
+    uint64_t    start;      // num_instr at the checkpoint.
+} sample_job_t;
+
+static char printbuf[BUF_LEN];
+static sample_job_t *jobs;
+static unsigned max_jobs, num_running;
+static int child_fd = -1;       // In a child, the write end of its pipe.
+static double *metrics[DETAIL_MAX_MODELS];
+static unsigned num_samples, cap_samples, num_failed;
+static double start_secs;
+static bool finished;
+
+bool sample_init(const unsigned n) {
+    max_jobs = n ? n : (unsigned) sysconf(_SC_NPROCESSORS_ONLN);
+    if (0 == max_jobs) max_jobs = 1;
+    jobs = calloc(max_jobs, sizeof(sample_job_t));
+    start_secs = now_secs();
+    return NULL != jobs;
+}
+
+/*
+ * Wait for a child to finish and fold its statistics in. The child's pipe
+ * is read before the child is waited for, as the models may not fit in
+ * the pipe's buffer.
+ */
+
+static void reap(void) {
+    struct pollfd fds[num_running];
+    for (unsigned j = 0; j < num_running; j++) fds[j] = (struct pollfd) {jobs[j].fd, POLLIN, 0};
+    while (poll(fds, num_running, -1) < 0)
+        if (EINTR != errno) { // Lost track of them.
+            for (unsigned j = 0; j < num_running; j++) close(jobs[j].fd);
+            num_failed += num_running;
+            num_running = 0;
+            return;
+        }
+    unsigned j = 0;
+    while (j < num_running - 1 && !fds[j].revents) j++;
+    sample_job_t job = jobs[j];
+    jobs[j] = jobs[--num_running];
+
+    unsigned n = detail_num_models();
+    timing_model_t *got = calloc(n, sizeof(timing_model_t));
+    size_t want = n * sizeof(timing_model_t), have = 0;
+    ssize_t r;
+    int status = 0;
+    while (have < want && ((r = read(job.fd, (char *) got + have, want - have)) > 0 || (r < 0 && EINTR == errno)))
+        if (r > 0) have += r;
+    close(job.fd);
+    waitpid(job.pid, &status, 0);
+    if (have < want || !WIFEXITED(status) || 0 != WEXITSTATUS(status)) {
+        sprintf(printbuf, "Sample at instr %lu failed", job.start);
+        logging(LOG_WARNING, printbuf);
+        num_failed++;
+    } else if (got[0].instrs) { // Empty if the program ended during warm-up.
+        if (num_samples == cap_samples) {
+            cap_samples = cap_samples ? 2 * cap_samples : 64;
+            for (unsigned i = 0; i < n; i++)
+                metrics[i] = realloc(metrics[i], cap_samples * sizeof(double));
+        }
+        for (unsigned i = 0; i < n; i++) {
+            const char *name;
+            timing_model_add_stats(detail_model(i), got + i);
+            metrics[i][num_samples] = timing_model_metric(got + i, &name);
+        }
+        num_samples++;
+    }
+    free(got);
+}
+
+/*
+ * Checkpoint the run at the current instruction. Returns true in the child,
+ * which is to simulate the sample, and false in the parent, which carries
+ * on (also if the fork failed).
+ */
+
+bool sample_fork(void) {
+    int fds[2];
+    while (num_running == max_jobs) reap();
+    fflush(NULL);
+    if (0 != pipe(fds)) {
+        logging(LOG_WARNING, "Cannot create pipe for sample");
+        return false;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        logging(LOG_WARNING, "Cannot fork sample");
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+    if (0 == pid) {
+        close(fds[0]);
+        for (unsigned j = 0; j < num_running; j++) close(jobs[j].fd);
+        child_fd = fds[1];
+        // Leave the console and log to the parent.
+        int null = open("/dev/null", O_WRONLY);
+        if (null >= 0) dup2(null, STDOUT_FILENO);
+        errfile = fopen("/dev/null", "w");
+        if (NULL == errfile) errfile = stderr;
+        return true;
+    }
+    close(fds[1]);
+    jobs[num_running++] = (sample_job_t) {pid, fds[0], num_instr};
+    return false;
+}
+
+/*
+ * In a child, at the end of its sample: send the models to the parent,
+ * with no statistics if the program ended during the warm-up. Exits
+ * without running atexit handlers, which belong to the parent's run.
+ */
+
+void sample_child_exit(void) {
+    const char *p;
+    size_t left;
+    ssize_t w = 0;
+    if (detail_warming())
+        for (unsigned i = 0; i < detail_num_models(); i++)
+            timing_model_reset_stats(detail_model(i));
+    for (unsigned i = 0; i < detail_num_models() && w >= 0; i++)
+        for (p = (const char *) detail_model(i), left = sizeof(timing_model_t); left; p += w, left -= w)
+            if ((w = write(child_fd, p, left)) < 0) break;
+    _exit(w < 0 ? EXIT_FAILURE : EXIT_SUCCESS);
+}
+
+/*
+ * End of run: wait for the samples still running, then report. The summed
+ * statistics are reported by detail_finish, which is to be called after
+ * this. Safe to call more than once, so that it can also be registered
+ * with atexit for runs ending in HLT.
+ */
+
+void sample_finish(void) {
+    if (child_fd >= 0) sample_child_exit(); // A sample ending in HLT.
+    if (finished || NULL == jobs) return;
+    finished = true;
+    while (num_running) reap();
+    sprintf(printbuf, "Sampling: %u samples, %u failed, %u jobs, %.3fs",
+            num_samples, num_failed, max_jobs, now_secs() - start_secs);
+    logging(LOG_INFO, printbuf);
+    for (unsigned i = 0; i < detail_num_models() && num_samples; i++) {
+        const char *name;
+        double sum = 0.0, sq = 0.0;
+        timing_model_metric(detail_model(i), &name);
+        for (unsigned s = 0; s < num_samples; s++) sum += metrics[i][s];
+        double mean = sum / num_samples;
+        for (unsigned s = 0; s < num_samples; s++) sq += (metrics[i][s] - mean) * (metrics[i][s] - mean);
+        double sd = num_samples > 1 ? sqrt(sq / (num_samples - 1)) : 0.0;
+        double ci = 1.96 * sd / sqrt(num_samples);
+        fprintf(errfile, "config=\"%s\"\tsamples=%u\t%s=%.4f\tci95=%.4f\trel_err=%.2f%%\n",
+                detail_model(i)->config, num_samples, name, mean, ci, mean > 0 ? 100.0 * ci / mean : 0.0);
+    }
+}
@@ -0,0 +1,210 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * smp.c - Guest cores on host threads.
+ *
+ * Each thread copies the main thread's guest and points its proc at its
+ * own core, so the instruction handlers, which all go through guest.proc,
+ * run unchanged. num_instr is per thread too; the main thread is left
+ * with the total.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "archsim.h"
+#include "coherence.h"
+#include "util.h"
+
+extern __thread machine_t guest;
+
+typedef struct core {
+    pthread_t   thread;
+    unsigned    id;
+    uint64_t    instrs;     // Instructions it retired.
+} core_t;
+
+static char printbuf[BUF_LEN];
+static machine_t boot;          // The main thread's guest.
+static core_t *cores;
+static atomic_int halted;       // 1 + the core that ran HLT, or 0.
+static coh_t *coh;              // The coherence model, if any.
+static pthread_mutex_t coh_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Deterministic mode: whose turn it is, and which cores have finished.
+static pthread_mutex_t turn_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t turn_cond = PTHREAD_COND_INITIALIZER;
+static unsigned turn;
+static bool *finished;
+
+static void wait_turn(const unsigned id) {
+    pthread_mutex_lock(&turn_lock);
+    while (turn != id) pthread_cond_wait(&turn_cond, &turn_lock);
+    pthread_mutex_unlock(&turn_lock);
+}
+
+// Hand the turn to the next core in order that has not finished, if any.
+static void pass_turn(const unsigned id, const bool done) {
+    pthread_mutex_lock(&turn_lock);
+    finished[id] = done;
+    for (unsigned k = 1; k <= boot.num_cores; k++) {
+        unsigned next = (id + k) % boot.num_cores;
+        if (!finished[next]) {
+            turn = next;
+            break;
+        }
+    }
+    pthread_cond_broadcast(&turn_cond);
+    pthread_mutex_unlock(&turn_lock);
+}
+
+/*
+ * The coherence model must see the cores' data accesses in the order they
+ * are made. Free-running cores therefore hold coh_lock from just before an
+ * instruction's memory stage until the model has its access; cores taking
+ * turns are serialized already. begin_access is called after the execute
+ * stage, which computes the address, and returns false if the instruction
+ * core id is running from pc makes no data access. end_access follows the
+ * memory stage. A store-exclusive that failed wrote nothing and is left
+ * out, so that retry loops are charged only for the stores that took.
+ */
+
+static bool begin_access(trace_rec_t *rec, const instr_t *insn, const uint64_t pc) {
+    trace_fill(rec, insn, pc, pc + 4); // The next PC does not matter here.
+    if (0 == rec->mem_width || mmio_is_reserved(rec->mem_addr)) return false;
+    if (!smp_quantum) pthread_mutex_lock(&coh_lock);
+    return true;
+}
+
+static void end_access(const unsigned id, const trace_rec_t *rec, const instr_t *insn) {
+    if (!((OP_STXR == insn->op || OP_STXR_W == insn->op) && insn->val_mem.xval))
+        coh_access(coh, id, rec->pc, rec->mem_addr, rec->mem_width, rec->is_store);
+    if (!smp_quantum) pthread_mutex_unlock(&coh_lock);
+}
+
+/*
+ * Stop every core after the HLT the calling core is running, if this is a
+ * multicore run. Called by update_pc_halt, which ends the run itself
+ * otherwise.
+ */
+
+bool smp_halt(void) {
+    if (NULL == cores) return false;
+    int none = 0;
+    atomic_compare_exchange_strong(&halted, &none, 1 + (int) (guest.proc - guest.procs));
+    return true;
+}
+
+/*
+ * Run one core until it returns from main, uses up its budget or some
+ * core halts, a turn of smp_quantum instructions at a time if that is
+ * nonzero. Instructions are not shown, even under DEBUG, as the cores'
+ * would interleave.
+ */
+
+static void *run_core(void *arg) {
+    core_t *c = arg;
+    guest = boot;
+    guest.proc = guest.procs + c->id;
+    num_instr = 0;
+    uint64_t budget = max_num_instr ? max_num_instr : UINT64_MAX;
+    uint64_t quantum = smp_quantum ? smp_quantum : UINT64_MAX;
+    bool running = true;
+    while (running) {
+        if (smp_quantum) wait_turn(c->id);
+        for (uint64_t n = 0; n < quantum; n++) {
+            if (guest.proc->regs[R_PC].xval == RET_FROM_MAIN_ADDR || num_instr >= budget ||
+                atomic_load_explicit(&halted, memory_order_relaxed)) {
+                running = false;
+                break;
+            }
+            uint64_t pc = guest.proc->regs[R_PC].xval;
+            instr_t insn;
+            trace_rec_t rec;
+            memset(&insn, 0, sizeof(insn));
+            fetch_instr(&insn);
+            decode_instr(&insn);
+            execute_instr(&insn);
+            bool noted = coh && begin_access(&rec, &insn, pc);
+            memory_instr(&insn);
+            if (noted) end_access(c->id, &rec, &insn);
+            wback_instr(&insn);
+            update_pc_instr(&insn);
+            num_instr++;
+        }
+        if (smp_quantum) pass_turn(c->id, !running);
+    }
+    c->instrs = num_instr;
+    return NULL;
+}
+
+/*
+ * Run the guest from entry on guest_cores cores. Called by runElf.
+ */
+
+int smp_run(const uint64_t entry) {
+    unsigned n = guest_cores ? guest_cores : 1;
+    if (trace_file || bbv_file || detail_num_models() || sample_period || ff_instrs || ff_until || roi_only) {
+        logging(LOG_FATAL, "Multicore runs take none of -t, -m, -V, -P, -f, -F and -R");
+        exit(EXIT_FAILURE);
+    }
+    if (coh_config && NULL == (coh = coh_create(coh_config, n))) {
+        logging(LOG_FATAL, "Bad coherence model configuration");
+        exit(EXIT_FAILURE);
+    }
+    init_cores(n);
+    for (unsigned i = 0; i < n; i++) {
+        gpregval_t *regs = guest.procs[i].regs;
+        regs[R_PC].xval = entry;
+        regs[R_SP].xval = guest.mem->seg_start_addr[KERNEL_SEG] - 8 - i * SMP_STACK_SIZE;
+        regs[R_NZCV].ccval = PACK_CC(0, 1, 0, 0);
+        regs[30].xval = RET_FROM_MAIN_ADDR;
+        regs[0].xval = i;
+        regs[1].xval = n;
+    }
+    boot = guest;
+    cores = calloc(n, sizeof(core_t));
+    finished = calloc(n, sizeof(bool));
+    turn = 0;
+    atomic_store(&halted, 0);
+
+    double start = now_secs();
+    for (unsigned i = 0; i < n; i++) {
+        cores[i].id = i;
+        if (pthread_create(&cores[i].thread, NULL, run_core, cores + i)) {
+            logging(LOG_FATAL, "Cannot start guest core threads");
+            exit(EXIT_FAILURE);
+        }
+    }
+    uint64_t total = 0;
+    for (unsigned i = 0; i < n; i++) {
+        pthread_join(cores[i].thread, NULL);
+        total += cores[i].instrs;
+    }
+    double secs = now_secs() - start;
+
+    for (unsigned i = 0; i < n; i++) {
+        sprintf(printbuf, "SMP: core %u retired %lu instrs", i, cores[i].instrs);
+        logging(LOG_INFO, printbuf);
+    }
+    sprintf(printbuf, "SMP: %u cores, %lu instrs, %.3fs, %.2f MIPS", 
+            n, total, secs, secs > 0 ? total / secs * 1e-6 : 0.0);
+    logging(LOG_INFO, printbuf);
+    int halter = atomic_load(&halted);
+    if (halter) {
+        sprintf(printbuf, "SMP: core %d halted", halter - 1);
+        logging(LOG_INFO, printbuf);
+    }
+    if (coh) {
+        coh_report(coh, errfile);
+        coh_free(coh);
+        coh = NULL;
+    }
+    num_instr = total;
+    free(cores);
+    free(finished);
+    cores = NULL;
+    return halter ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,225 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * stackdist.c - LRU stack-distance cache sweep.
+ *
+ * Access times grow without bound, so when they reach the size of the
+ * Fenwick tree the lines' latest times are renumbered densely, in order,
+ * and the tree rebuilt; it is doubled if the lines would fill more than
+ * half of it. The table from line to latest time is never shrunk: the
+ * sweep's memory is proportional to the number of distinct lines touched.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+#include "stackdist.h"
+#include "util.h"
+
+#define SD_INITIAL_CAP (1ULL << 16)
+
+static inline unsigned log2u(uint64_t x) {
+    unsigned n = 0;
+    while (x >>= 1) n++;
+    return n;
+}
+
+// Number of significant bits: 0 for 0, 1 for 1, 2 for 2-3, 3 for 4-7, ...
+static inline unsigned bits(const uint64_t x) {return x ? 64 - __builtin_clzll(x) : 0;}
+
+static inline uint64_t hash_line(const uint64_t line) {return line * 0x9E3779B97F4A7C15ULL;}
+
+/*
+ * Set up a sweep of capacities min..max bytes and associativities up to
+ * assoc. Returns false if the range is not realizable (all four must be
+ * powers of two, with line <= min <= max).
+ */
+
+bool stackdist_init(stackdist_t *sd, const unsigned min, const unsigned max,
+                    const unsigned assoc, const unsigned line) {
+    memset(sd, 0, sizeof(*sd));
+    if (!is_pow2(line) || !is_pow2(min) || !is_pow2(max) || !is_pow2(assoc)) return false;
+    if (min < line || max < min || assoc > SD_MAX_ASSOC) return false;
+    sd->line_bits = log2u(line);
+    sd->min_bits = log2u(min) - sd->line_bits;
+    sd->max_bits = log2u(max) - sd->line_bits;
+    sd->assoc = assoc;
+    if (sd->max_bits > SD_MAX_SET_BITS) return false;
+    unsigned abits = log2u(assoc);
+    sd->set_lo = sd->min_bits > abits ? sd->min_bits - abits : 0;
+    for (unsigned s = sd->set_lo; s <= sd->max_bits; s++) {
+        unsigned room = 1U << (sd->max_bits - s); // Lines per set in the largest cache.
+        sd->depth[s] = room < assoc ? room : assoc;
+        sd->stacks[s] = calloc((size_t) sd->depth[s] << s, sizeof(uint64_t));
+    }
+    sd->cap = SD_INITIAL_CAP;
+    sd->tree = calloc(sd->cap + 1, sizeof(uint32_t));
+    sd->hash_size = SD_INITIAL_CAP;
+    sd->keys = calloc(sd->hash_size, sizeof(uint64_t));
+    sd->times = calloc(sd->hash_size, sizeof(uint64_t));
+    return true;
+}
+
+void stackdist_free(stackdist_t *sd) {
+    for (unsigned s = 0; s <= SD_MAX_SET_BITS; s++) free(sd->stacks[s]);
+    free(sd->tree);
+    free(sd->keys);
+    free(sd->times);
+    memset(sd, 0, sizeof(*sd));
+}
+
+void stackdist_reset_stats(stackdist_t *sd) {
+    sd->accesses = sd->cold = 0;
+    memset(sd->dist, 0, sizeof(sd->dist));
+    memset(sd->hits, 0, sizeof(sd->hits));
+}
+
+/*
+ * Add the statistics of sd to those of sum, a sweep of the same range.
+ * Only sd's counters are read.
+ */
+
+void stackdist_add_stats(stackdist_t *sum, const stackdist_t *sd) {
+    sum->accesses += sd->accesses;
+    sum->cold += sd->cold;
+    for (unsigned b = 0; b < SD_DIST_BUCKETS; b++) sum->dist[b] += sd->dist[b];
+    for (unsigned s = 0; s <= SD_MAX_SET_BITS; s++)
+        for (unsigned p = 0; p < SD_MAX_ASSOC; p++) sum->hits[s][p] += sd->hits[s][p];
+}
+
+/*
+ * The Fenwick tree.
+ */
+
+static inline void tree_add(stackdist_t *sd, uint64_t i, const int32_t v) {
+    for (i++; i <= sd->cap; i += i & -i) sd->tree[i] += v;
+}
+
+// Marks at times [0, i).
+static inline uint64_t tree_sum(const stackdist_t *sd, uint64_t i) {
+    uint64_t s = 0;
+    for (; i; i -= i & -i) s += sd->tree[i];
+    return s;
+}
+
+/*
+ * The table from line to latest access time.
+ */
+
+static uint64_t *find_slot(stackdist_t *sd, const uint64_t line) {
+    uint64_t mask = sd->hash_size - 1, h = hash_line(line) & mask;
+    while (sd->keys[h] && sd->keys[h] != line + 1) h = (h + 1) & mask;
+    return sd->keys + h;
+}
+
+static void grow_table(stackdist_t *sd) {
+    uint64_t *keys = sd->keys, *times = sd->times, n = sd->hash_size;
+    sd->hash_size *= 2;
+    sd->keys = calloc(sd->hash_size, sizeof(uint64_t));
+    sd->times = calloc(sd->hash_size, sizeof(uint64_t));
+    for (uint64_t i = 0; i < n; i++) {
+        if (!keys[i]) continue;
+        uint64_t *slot = find_slot(sd, keys[i] - 1);
+        *slot = keys[i];
+        sd->times[slot - sd->keys] = times[i];
+    }
+    free(keys);
+    free(times);
+}
+
+/*
+ * Renumber the latest times 0 .. num_lines-1, keeping their order, and
+ * rebuild the tree with them marked.
+ */
+
+static void renumber(stackdist_t *sd) {
+    uint64_t *slot_at = malloc(sd->cap * sizeof(uint64_t));
+    memset(slot_at, 0xFF, sd->cap * sizeof(uint64_t));
+    for (uint64_t i = 0; i < sd->hash_size; i++)
+        if (sd->keys[i]) slot_at[sd->times[i]] = i;
+    uint64_t t = 0;
+    for (uint64_t i = 0; i < sd->cap; i++)
+        if (UINT64_MAX != slot_at[i]) sd->times[slot_at[i]] = t++;
+    free(slot_at);
+    sd->now = t;
+    if (2 * t > sd->cap) {
+        sd->cap *= 2;
+        free(sd->tree);
+        sd->tree = malloc((sd->cap + 1) * sizeof(uint32_t));
+    }
+    // Linear-time build of a tree with times [0, t) marked.
+    memset(sd->tree, 0, (sd->cap + 1) * sizeof(uint32_t));
+    for (uint64_t i = 1; i <= sd->cap; i++) {
+        if (i <= t) sd->tree[i]++;
+        uint64_t j = i + (i & -i);
+        if (j <= sd->cap) sd->tree[j] += sd->tree[i];
+    }
+}
+
+static void access_line(stackdist_t *sd, const uint64_t line) {
+    sd->accesses++;
+
+    // Fully associative.
+    uint64_t *slot = find_slot(sd, line);
+    uint64_t *time = sd->times + (slot - sd->keys);
+    if (*slot) {
+        uint64_t d = tree_sum(sd, sd->now) - tree_sum(sd, *time + 1);
+        sd->dist[bits(d)]++;
+        tree_add(sd, *time, -1);
+    } else {
+        sd->cold++;
+        *slot = line + 1;
+        if (2 * ++sd->num_lines > sd->hash_size) {
+            grow_table(sd);
+            time = sd->times + (find_slot(sd, line) - sd->keys);
+        }
+    }
+    *time = sd->now;
+    tree_add(sd, sd->now, 1);
+    if (++sd->now == sd->cap) renumber(sd);
+
+    // Set associative.
+    for (unsigned s = sd->set_lo; s <= sd->max_bits; s++) {
+        unsigned depth = sd->depth[s], p = 0;
+        uint64_t *stack = sd->stacks[s] + (line & ((1ULL << s) - 1)) * depth;
+        while (p < depth && stack[p] != line + 1) p++;
+        if (p < depth) sd->hits[s][p]++;
+        else p = depth - 1;
+        memmove(stack + 1, stack, p * sizeof(uint64_t));
+        stack[0] = line + 1;
+    }
+}
+
+/*
+ * Access width bytes at addr. An access that straddles a line boundary
+ * touches both lines, as in cache.c.
+ */
+
+void stackdist_access(stackdist_t *sd, const uint64_t addr, const unsigned width) {
+    uint64_t first = addr >> sd->line_bits;
+    uint64_t last = (addr + (width ? width - 1 : 0)) >> sd->line_bits;
+    access_line(sd, first);
+    if (last != first) access_line(sd, last);
+}
+
+/*
+ * Miss rate of a cache of size bytes with the given associativity, or
+ * fully associative if assoc is 0. Both must be within the sweep's range.
+ */
+
+double stackdist_miss_rate(const stackdist_t *sd, const unsigned size, const unsigned assoc) {
+    if (0 == sd->accesses) return 0.0;
+    unsigned cbits = log2u(size) - sd->line_bits;
+    uint64_t misses;
+    if (0 == assoc) {
+        misses = sd->cold;
+        for (unsigned b = cbits + 1; b < SD_DIST_BUCKETS; b++) misses += sd->dist[b];
+    } else {
+        unsigned s = cbits - log2u(assoc);
+        misses = sd->accesses;
+        for (unsigned p = 0; p < assoc; p++) misses -= sd->hits[s][p];
+    }
+    return (double) misses / sd->accesses;
+}
@@ -0,0 +1,442 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * timing.c - Construction, dispatch and reporting for timing models.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include "timing.h"
+#include "ptable.h"
+#include "util.h"
+
+#define MAX_CONFIG_LEN 256
+
+static char *model_names[] = {"cache", "bpred", "inorder", "sweep", "ooo", "tlb"};
+
+static model_kind_t model_kind(const char *name) {
+    for (int i = MODEL_CACHE; i <= MODEL_TLB; i++)
+        if (0 == strcmp(name, model_names[i])) return (model_kind_t) i;
+    return MODEL_ERROR;
+}
+
+static cache_side_t cache_side(const char *name) {
+    if (0 == strcmp(name, "i")) return SIDE_I;
+    if (0 == strcmp(name, "d")) return SIDE_D;
+    if (0 == strcmp(name, "u")) return SIDE_U;
+    return SIDE_ERROR;
+}
+
+/*
+ * Parse an unsigned number with an optional K or M suffix.
+ */
+
+bool timing_parse_size(const char *s, unsigned *out) {
+    char *end;
+    unsigned long v = strtoul(s, &end, 0);
+    if (end == s) return false;
+    if ('K' == *end || 'k' == *end) {v <<= 10; end++;}
+    else if ('M' == *end || 'm' == *end) {v <<= 20; end++;}
+    if ('\0' != *end) return false;
+    *out = (unsigned) v;
+    return true;
+}
+
+/*
+ * Build a model from a configuration line (see timing.h). Returns NULL if
+ * the line does not describe a valid model.
+ */
+
+timing_model_t *timing_model_create(const char *config) {
+    char buf[MAX_CONFIG_LEN], *save, *tok;
+    if (strlen(config) >= MAX_CONFIG_LEN) return NULL;
+    strcpy(buf, config);
+    if (NULL == (tok = strtok_r(buf, " \t\n", &save))) return NULL;
+    model_kind_t kind = model_kind(tok);
+    if (MODEL_ERROR == kind) return NULL;
+
+    // Defaults.
+    unsigned size = 32 << 10, l1i = 32 << 10, l1d = 32 << 10, assoc = 4, line = 64;
+    unsigned bits = 12, miss = 20, mispredict = 3, taken = 1, min = 1 << 10, max = 1 << 20;
+    ooo_params_t op = {.fetch = 4, .issue = 4, .retire = 4, .rob = 128, .iq = 32, .prf = 160, .lsq = 48,
+                       .ports = 2, .lat = {[FU_ALU] = 1, [FU_BRANCH] = 1, [FU_LOAD] = 3, [FU_STORE] = 1}};
+    dram_params_t dp = {.channels = 0, .banks = 8, .row = 8 << 10, .policy = DRAM_OPEN,
+                        .trcd = 42, .tcas = 42, .trp = 42, .tburst = 8, .wq = 32};
+    tlb_params_t tp = {.itlb = 64, .dtlb = 64, .stlb = 1536, .assoc = 4, .stlb_assoc = 12, .stlb_hit = 7,
+                       .page = PAGESIZE, .pwc = 32, .walk = 20};
+    unsigned use_tlb = 0;
+    cache_side_t side = SIDE_D;
+    bpred_kind_t bkind = BP_GSHARE;
+    bool ok = true;
+
+    while (ok && NULL != (tok = strtok_r(NULL, " \t\n", &save))) {
+        char *val = strchr(tok, '=');
+        if (NULL == val) {ok = false; break;}
+        *val++ = '\0';
+        if (0 == strcmp(tok, "size")) ok = timing_parse_size(val, &size);
+        else if (0 == strcmp(tok, "l1i")) ok = timing_parse_size(val, &l1i);
+        else if (0 == strcmp(tok, "l1d")) ok = timing_parse_size(val, &l1d);
+        else if (0 == strcmp(tok, "assoc")) ok = timing_parse_size(val, &assoc);
+        else if (0 == strcmp(tok, "line")) ok = timing_parse_size(val, &line);
+        else if (0 == strcmp(tok, "min")) ok = timing_parse_size(val, &min);
+        else if (0 == strcmp(tok, "max")) ok = timing_parse_size(val, &max);
+        else if (0 == strcmp(tok, "bits")) ok = timing_parse_size(val, &bits);
+        else if (0 == strcmp(tok, "miss")) ok = timing_parse_size(val, &miss);
+        else if (0 == strcmp(tok, "mispredict")) ok = timing_parse_size(val, &mispredict);
+        else if (0 == strcmp(tok, "taken")) ok = timing_parse_size(val, &taken);
+        else if (0 == strcmp(tok, "fetch")) ok = timing_parse_size(val, &op.fetch);
+        else if (0 == strcmp(tok, "issue")) ok = timing_parse_size(val, &op.issue);
+        else if (0 == strcmp(tok, "retire")) ok = timing_parse_size(val, &op.retire);
+        else if (0 == strcmp(tok, "rob")) ok = timing_parse_size(val, &op.rob);
+        else if (0 == strcmp(tok, "iq")) ok = timing_parse_size(val, &op.iq);
+        else if (0 == strcmp(tok, "prf")) ok = timing_parse_size(val, &op.prf);
+        else if (0 == strcmp(tok, "lsq")) ok = timing_parse_size(val, &op.lsq);
+        else if (0 == strcmp(tok, "ports")) ok = timing_parse_size(val, &op.ports);
+        else if (0 == strcmp(tok, "alu")) ok = timing_parse_size(val, &op.lat[FU_ALU]);
+        else if (0 == strcmp(tok, "branch")) ok = timing_parse_size(val, &op.lat[FU_BRANCH]);
+        else if (0 == strcmp(tok, "load")) ok = timing_parse_size(val, &op.lat[FU_LOAD]);
+        else if (0 == strcmp(tok, "store")) ok = timing_parse_size(val, &op.lat[FU_STORE]);
+        else if (0 == strcmp(tok, "channels")) ok = timing_parse_size(val, &dp.channels);
+        else if (0 == strcmp(tok, "banks")) ok = timing_parse_size(val, &dp.banks);
+        else if (0 == strcmp(tok, "row")) ok = timing_parse_size(val, &dp.row);
+        else if (0 == strcmp(tok, "page")) ok = DRAM_ERROR != (dp.policy = dram_policy(val));
+        else if (0 == strcmp(tok, "trcd")) ok = timing_parse_size(val, &dp.trcd);
+        else if (0 == strcmp(tok, "tcas")) ok = timing_parse_size(val, &dp.tcas);
+        else if (0 == strcmp(tok, "trp")) ok = timing_parse_size(val, &dp.trp);
+        else if (0 == strcmp(tok, "tburst")) ok = timing_parse_size(val, &dp.tburst);
+        else if (0 == strcmp(tok, "wq")) ok = timing_parse_size(val, &dp.wq);
+        else if (0 == strcmp(tok, "itlb")) ok = timing_parse_size(val, &tp.itlb);
+        else if (0 == strcmp(tok, "dtlb")) ok = timing_parse_size(val, &tp.dtlb);
+        else if (0 == strcmp(tok, "stlb")) ok = timing_parse_size(val, &tp.stlb);
+        else if (0 == strcmp(tok, "tlbassoc")) ok = timing_parse_size(val, &tp.assoc);
+        else if (0 == strcmp(tok, "stlbassoc")) ok = timing_parse_size(val, &tp.stlb_assoc);
+        else if (0 == strcmp(tok, "stlbhit")) ok = timing_parse_size(val, &tp.stlb_hit);
+        else if (0 == strcmp(tok, "pagesize")) ok = timing_parse_size(val, &tp.page);
+        else if (0 == strcmp(tok, "pwc")) ok = timing_parse_size(val, &tp.pwc);
+        else if (0 == strcmp(tok, "walk")) ok = timing_parse_size(val, &tp.walk);
+        else if (0 == strcmp(tok, "tlb")) ok = timing_parse_size(val, &use_tlb);
+        else if (0 == strcmp(tok, "side")) ok = SIDE_ERROR != (side = cache_side(val));
+        else if (0 == strcmp(tok, "kind") || 0 == strcmp(tok, "bpred"))
+            ok = BP_ERROR != (bkind = bpred_kind(val));
+        else ok = false;
+    }
+    if (!ok) return NULL;
+
+    timing_model_t *m = calloc(1, sizeof(timing_model_t));
+    m->kind = kind;
+    m->config = strdup(config);
+    m->config[strcspn(m->config, "\n")] = '\0';
+    switch (kind) {
+        case MODEL_CACHE:
+            m->side = side;
+            ok = cache_init(&m->cache, size, assoc, line);
+            break;
+        case MODEL_BPRED:
+            ok = bpred_init(&m->bp, bkind, bits);
+            break;
+        case MODEL_INORDER:
+            m->core.miss_lat = miss;
+            m->core.mispredict_pen = mispredict;
+            m->core.taken_pen = taken;
+            ok = cache_init(&m->core.l1i, l1i, assoc, line) &&
+                 cache_init(&m->core.l1d, l1d, assoc, line) &&
+                 bpred_init(&m->core.bp, bkind, bits) &&
+                 (0 == dp.channels || dram_init(&m->core.dram, &dp, line)) &&
+                 (0 == use_tlb || tlb_init(&m->core.tlb, &tp));
+            break;
+        case MODEL_SWEEP:
+            m->side = side;
+            ok = stackdist_init(&m->sweep, min, max, assoc, line);
+            break;
+        case MODEL_OOO:
+            op.miss_lat = miss;
+            op.mispredict_pen = mispredict;
+            op.taken_pen = taken;
+            ok = ooo_init(&m->ooo, &op) &&
+                 cache_init(&m->ooo.l1i, l1i, assoc, line) &&
+                 cache_init(&m->ooo.l1d, l1d, assoc, line) &&
+                 bpred_init(&m->ooo.bp, bkind, bits) &&
+                 (0 == dp.channels || dram_init(&m->ooo.dram, &dp, line)) &&
+                 (0 == use_tlb || tlb_init(&m->ooo.tlb, &tp));
+            break;
+        case MODEL_TLB:
+            ok = tlb_init(&m->tlb, &tp);
+            break;
+        default: assert(false); break;
+    }
+    if (!ok) {
+        timing_model_free(m);
+        return NULL;
+    }
+    return m;
+}
+
+void timing_model_free(timing_model_t *m) {
+    cache_free(&m->cache);
+    bpred_free(&m->bp);
+    cache_free(&m->core.l1i);
+    cache_free(&m->core.l1d);
+    bpred_free(&m->core.bp);
+    dram_free(&m->core.dram);
+    tlb_free(&m->core.tlb);
+    stackdist_free(&m->sweep);
+    cache_free(&m->ooo.l1i);
+    cache_free(&m->ooo.l1d);
+    bpred_free(&m->ooo.bp);
+    dram_free(&m->ooo.dram);
+    tlb_free(&m->ooo.tlb);
+    ooo_free(&m->ooo);
+    tlb_free(&m->tlb);
+    free(m->config);
+    free(m);
+}
+
+// An L1 miss at the current cycle: the miss latency, then the DRAM's.
+static inline void inorder_miss(inorder_t *core, const cache_t *c, const uint64_t wb, const uint64_t addr) {
+    core->cycles += core->miss_lat;
+    core->cycles += dram_fill(&core->dram, c, wb, addr, core->cycles);
+}
+
+static inline void consume_inorder(inorder_t *core, const trace_rec_t *rec) {
+    uint64_t wb = core->l1d.writebacks;
+    core->cycles++;
+    if (tlb_enabled(&core->tlb)) {
+        core->cycles += tlb_translate(&core->tlb, rec->pc, true);
+        if (rec->mem_width) core->cycles += tlb_translate(&core->tlb, rec->mem_addr, false);
+    }
+    if (!cache_access(&core->l1i, rec->pc, 4, false))
+        inorder_miss(core, &core->l1i, core->l1i.writebacks, rec->pc);
+    if (rec->mem_width && !cache_access(&core->l1d, rec->mem_addr, rec->mem_width, rec->is_store))
+        inorder_miss(core, &core->l1d, wb, rec->mem_addr);
+    if (OP_B_COND == rec->op && !bpred_update(&core->bp, rec->pc, rec->taken))
+        core->cycles += core->mispredict_pen;
+    else if (rec->taken) core->cycles += core->taken_pen;
+}
+
+void timing_model_consume(timing_model_t *m, const trace_rec_t *rec) {
+    m->instrs++;
+    switch (m->kind) {
+        case MODEL_CACHE:
+            if (SIDE_D != m->side) cache_access(&m->cache, rec->pc, 4, false);
+            if (SIDE_I != m->side && rec->mem_width)
+                cache_access(&m->cache, rec->mem_addr, rec->mem_width, rec->is_store);
+            break;
+        case MODEL_BPRED:
+            if (OP_B_COND == rec->op) bpred_update(&m->bp, rec->pc, rec->taken);
+            break;
+        case MODEL_INORDER:
+            consume_inorder(&m->core, rec);
+            break;
+        case MODEL_SWEEP:
+            if (SIDE_D != m->side) stackdist_access(&m->sweep, rec->pc, 4);
+            if (SIDE_I != m->side && rec->mem_width)
+                stackdist_access(&m->sweep, rec->mem_addr, rec->mem_width);
+            break;
+        case MODEL_OOO:
+            ooo_consume(&m->ooo, rec);
+            break;
+        case MODEL_TLB:
+            tlb_translate(&m->tlb, rec->pc, true);
+            if (rec->mem_width) tlb_translate(&m->tlb, rec->mem_addr, false);
+            break;
+        default: assert(false); break;
+    }
+}
+
+/*
+ * Clear statistics but keep microarchitectural state (tags, counters), so
+ * that a warmed-up model can start measuring.
+ */
+
+void timing_model_reset_stats(timing_model_t *m) {
+    m->instrs = 0;
+    cache_reset_stats(&m->cache);
+    bpred_reset_stats(&m->bp);
+    cache_reset_stats(&m->core.l1i);
+    cache_reset_stats(&m->core.l1d);
+    bpred_reset_stats(&m->core.bp);
+    dram_reset_stats(&m->core.dram);
+    tlb_reset_stats(&m->core.tlb);
+    m->core.cycles = 0;
+    stackdist_reset_stats(&m->sweep);
+    cache_reset_stats(&m->ooo.l1i);
+    cache_reset_stats(&m->ooo.l1d);
+    bpred_reset_stats(&m->ooo.bp);
+    dram_reset_stats(&m->ooo.dram);
+    tlb_reset_stats(&m->ooo.tlb);
+    ooo_reset_stats(&m->ooo);
+    tlb_reset_stats(&m->tlb);
+}
+
+static void add_cache_stats(cache_t *sum, const cache_t *c) {
+    sum->accesses += c->accesses;
+    sum->misses += c->misses;
+    sum->writebacks += c->writebacks;
+}
+
+static void add_bpred_stats(bpred_t *sum, const bpred_t *bp) {
+    sum->lookups += bp->lookups;
+    sum->mispredicts += bp->mispredicts;
+}
+
+/*
+ * Add the statistics of m to those of sum, a model of the same
+ * configuration. Only m's counters are read, so m may be a copy of a
+ * model made in another process.
+ */
+
+void timing_model_add_stats(timing_model_t *sum, const timing_model_t *m) {
+    sum->instrs += m->instrs;
+    add_cache_stats(&sum->cache, &m->cache);
+    add_bpred_stats(&sum->bp, &m->bp);
+    add_cache_stats(&sum->core.l1i, &m->core.l1i);
+    add_cache_stats(&sum->core.l1d, &m->core.l1d);
+    add_bpred_stats(&sum->core.bp, &m->core.bp);
+    dram_add_stats(&sum->core.dram, &m->core.dram);
+    tlb_add_stats(&sum->core.tlb, &m->core.tlb);
+    sum->core.cycles += m->core.cycles;
+    stackdist_add_stats(&sum->sweep, &m->sweep);
+    add_cache_stats(&sum->ooo.l1i, &m->ooo.l1i);
+    add_cache_stats(&sum->ooo.l1d, &m->ooo.l1d);
+    add_bpred_stats(&sum->ooo.bp, &m->ooo.bp);
+    dram_add_stats(&sum->ooo.dram, &m->ooo.dram);
+    tlb_add_stats(&sum->ooo.tlb, &m->ooo.tlb);
+    ooo_add_stats(&sum->ooo, &m->ooo);
+    tlb_add_stats(&sum->tlb, &m->tlb);
+}
+
+/*
+ * The model's headline figure, per instruction so that it can be averaged
+ * over samples: CPI for a core, misses or mispredicts per thousand
+ * instructions otherwise (for a sweep, in its smallest cache, fully
+ * associative).
+ */
+
+double timing_model_metric(const timing_model_t *m, const char **name) {
+    switch (m->kind) {
+        case MODEL_CACHE: *name = "mpki"; return 1000.0 * ratio(m->cache.misses, m->instrs);
+        case MODEL_BPRED: *name = "mpki"; return 1000.0 * ratio(m->bp.mispredicts, m->instrs);
+        case MODEL_INORDER: *name = "cpi"; return ratio(m->core.cycles, m->instrs);
+        case MODEL_OOO: *name = "cpi"; return ratio(m->ooo.cycles, m->instrs);
+        case MODEL_TLB: *name = "mpki"; return 1000.0 * ratio(m->tlb.walks, m->instrs);
+        case MODEL_SWEEP:
+            *name = "mpki";
+            return 1000.0 * stackdist_miss_rate(&m->sweep, 1U << (m->sweep.min_bits + m->sweep.line_bits), 0) *
+                   ratio(m->sweep.accesses, m->instrs);
+        default: assert(false); return 0.0;
+    }
+}
+
+static void print_size(const unsigned size, FILE *out) {
+    if (size >= 1 << 20) fprintf(out, "%uM", size >> 20);
+    else if (size >= 1 << 10) fprintf(out, "%uK", size >> 10);
+    else fprintf(out, "%u", size);
+}
+
+/*
+ * mr_<size>_fa for a fully associative cache and mr_<size>_<assoc> for
+ * each associativity, capacity by capacity.
+ */
+
+static void report_sweep(const stackdist_t *sd, FILE *out) {
+    for (unsigned b = sd->min_bits; b <= sd->max_bits; b++) {
+        unsigned size = 1U << (b + sd->line_bits);
+        fprintf(out, "\tmr_");
+        print_size(size, out);
+        fprintf(out, "_fa=%.6f", stackdist_miss_rate(sd, size, 0));
+        for (unsigned a = 1; a <= sd->assoc && a <= 1U << b; a <<= 1) {
+            fprintf(out, "\tmr_");
+            print_size(size, out);
+            fprintf(out, "_%u=%.6f", a, stackdist_miss_rate(sd, size, a));
+        }
+    }
+}
+
+/*
+ * Row-buffer outcomes over all DRAM accesses, bytes moved per core cycle
+ * and the average latency of a read, if the core has a DRAM.
+ */
+
+static void report_dram(const dram_t *d, const uint64_t cycles, FILE *out) {
+    if (!dram_enabled(d)) return;
+    uint64_t accesses = d->row_hits + d->row_empty + d->row_conflicts;
+    fprintf(out, "\tdram_reads=%lu\tdram_writes=%lu\trow_hit_rate=%.6f\trow_conflict_rate=%.6f",
+            d->reads, d->writes, ratio(d->row_hits, accesses), ratio(d->row_conflicts, accesses));
+    fprintf(out, "\tdram_bytes_per_cycle=%.4f\tdram_read_latency=%.2f",
+            ratio(accesses << d->line_bits, cycles), ratio(d->read_cycles, d->reads));
+}
+
+/*
+ * Misses per thousand instructions in each TLB (those of the STLB being
+ * page walks), and what the walks cost, if translation is modeled.
+ */
+
+static void report_tlb(const tlb_t *t, const uint64_t instrs, FILE *out) {
+    if (!tlb_enabled(t)) return;
+    fprintf(out, "\titlb_mpki=%.3f\tdtlb_mpki=%.3f\tstlb_mpki=%.3f",
+            1000.0 * ratio(t->itlb.misses, instrs), 1000.0 * ratio(t->dtlb.misses, instrs),
+            1000.0 * ratio(t->walks, instrs));
+    fprintf(out, "\tpwc_hit_rate=%.6f\trefs_per_walk=%.3f\ttlb_cycles=%lu",
+            ratio(t->pwc.accesses - t->pwc.misses, t->pwc.accesses), ratio(t->walk_refs, t->walks), t->cycles);
+}
+
+/*
+ * Print one line of tab-separated key=value pairs.
+ */
+
+void timing_model_report(const timing_model_t *m, FILE *out) {
+    fprintf(out, "config=\"%s\"\tinstrs=%lu", m->config, m->instrs);
+    switch (m->kind) {
+        case MODEL_CACHE:
+            fprintf(out, "\taccesses=%lu\tmisses=%lu\tmiss_rate=%.6f\tmpki=%.3f\twritebacks=%lu",
+                    m->cache.accesses, m->cache.misses, ratio(m->cache.misses, m->cache.accesses),
+                    1000.0 * ratio(m->cache.misses, m->instrs), m->cache.writebacks);
+            break;
+        case MODEL_BPRED:
+            fprintf(out, "\tbranches=%lu\tmispredicts=%lu\taccuracy=%.6f\tmpki=%.3f",
+                    m->bp.lookups, m->bp.mispredicts, 1.0 - ratio(m->bp.mispredicts, m->bp.lookups),
+                    1000.0 * ratio(m->bp.mispredicts, m->instrs));
+            break;
+        case MODEL_INORDER:
+            fprintf(out, "\tcycles=%lu\tcpi=%.4f\tl1i_miss_rate=%.6f\tl1d_miss_rate=%.6f\tbp_accuracy=%.6f",
+                    m->core.cycles, ratio(m->core.cycles, m->instrs),
+                    ratio(m->core.l1i.misses, m->core.l1i.accesses),
+                    ratio(m->core.l1d.misses, m->core.l1d.accesses),
+                    1.0 - ratio(m->core.bp.mispredicts, m->core.bp.lookups));
+            report_dram(&m->core.dram, m->core.cycles, out);
+            report_tlb(&m->core.tlb, m->instrs, out);
+            break;
+        case MODEL_SWEEP:
+            fprintf(out, "\taccesses=%lu\tcold=%lu", m->sweep.accesses, m->sweep.cold);
+            report_sweep(&m->sweep, out);
+            break;
+        case MODEL_OOO:
+            fprintf(out, "\tcycles=%lu\tipc=%.4f\tcpi=%.4f", m->ooo.cycles,
+                    ratio(m->instrs, m->ooo.cycles), ratio(m->ooo.cycles, m->instrs));
+            fprintf(out, "\trob_occ=%.2f\tiq_occ=%.2f\tlsq_occ=%.2f",
+                    ratio(m->ooo.rob_occ, m->ooo.cycles), ratio(m->ooo.iq_occ, m->ooo.cycles),
+                    ratio(m->ooo.lsq_occ, m->ooo.cycles));
+            fprintf(out, "\tstall_rob=%lu\tstall_iq=%lu\tstall_prf=%lu\tstall_lsq=%lu\tforwards=%lu",
+                    m->ooo.stall_rob, m->ooo.stall_iq, m->ooo.stall_prf, m->ooo.stall_lsq, m->ooo.forwards);
+            fprintf(out, "\tl1i_miss_rate=%.6f\tl1d_miss_rate=%.6f\tbp_accuracy=%.6f",
+                    ratio(m->ooo.l1i.misses, m->ooo.l1i.accesses),
+                    ratio(m->ooo.l1d.misses, m->ooo.l1d.accesses),
+                    1.0 - ratio(m->ooo.bp.mispredicts, m->ooo.bp.lookups));
+            report_dram(&m->ooo.dram, m->ooo.cycles, out);
+            report_tlb(&m->ooo.tlb, m->instrs, out);
+            break;
+        case MODEL_TLB:
+            fprintf(out, "\tmpki=%.3f", 1000.0 * ratio(m->tlb.walks, m->instrs));
+            report_tlb(&m->tlb, m->instrs, out);
+            break;
+        default: assert(false); break;
+    }
+    fprintf(out, "\n");
+}
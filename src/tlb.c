@@ -0,0 +1,101 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * tlb.c - Guest TLB and page-walk timing model.
+ *
+ * The TLBs and the PWC are tag-only caches (cache.c) with one-byte lines,
+ * looked up by page number or, for the PWC, by the address bits that
+ * select an entry at some level, tagged with the level. An access that
+ * straddles two pages is translated for the first only.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <string.h>
+#include "tlb.h"
+#include "ptable.h"
+
+/*
+ * Set up empty TLBs. Returns false if the page size is not one the page
+ * table can map or a TLB's geometry is not realizable.
+ */
+
+bool tlb_init(tlb_t *t, const tlb_params_t *p) {
+    memset(t, 0, sizeof(*t));
+    unsigned bits = 0;
+    while ((1ULL << bits) < p->page) bits++;
+    if (p->page < PAGESIZE || (1ULL << bits) != p->page || 0 == p->walk) return false;
+    if ((bits - TLB_BASE_BITS) % TLB_LEVEL_BITS || bits >= TLB_BASE_BITS + 3 * TLB_LEVEL_BITS) return false;
+    t->p = *p;
+    t->page_bits = bits;
+    t->leaf = 1 + (bits - TLB_BASE_BITS) / TLB_LEVEL_BITS;
+    return cache_init(&t->itlb, p->itlb, p->assoc, 1) &&
+           cache_init(&t->dtlb, p->dtlb, p->assoc, 1) &&
+           cache_init(&t->stlb, p->stlb, p->stlb_assoc, 1) &&
+           (0 == p->pwc || cache_init(&t->pwc, p->pwc, p->pwc, 1));
+}
+
+void tlb_free(tlb_t *t) {
+    cache_free(&t->itlb);
+    cache_free(&t->dtlb);
+    cache_free(&t->stlb);
+    cache_free(&t->pwc);
+    memset(t, 0, sizeof(*t));
+}
+
+void tlb_reset_stats(tlb_t *t) {
+    cache_reset_stats(&t->itlb);
+    cache_reset_stats(&t->dtlb);
+    cache_reset_stats(&t->stlb);
+    cache_reset_stats(&t->pwc);
+    t->walks = t->walk_refs = t->cycles = 0;
+}
+
+static void add_lookups(cache_t *sum, const cache_t *c) {
+    sum->accesses += c->accesses;
+    sum->misses += c->misses;
+}
+
+void tlb_add_stats(tlb_t *sum, const tlb_t *t) {
+    add_lookups(&sum->itlb, &t->itlb);
+    add_lookups(&sum->dtlb, &t->dtlb);
+    add_lookups(&sum->stlb, &t->stlb);
+    add_lookups(&sum->pwc, &t->pwc);
+    sum->walks += t->walks;
+    sum->walk_refs += t->walk_refs;
+    sum->cycles += t->cycles;
+}
+
+/*
+ * Page-table references a walk for addr makes: one per level below the
+ * deepest upper-level entry the PWC holds, which are then all cached.
+ */
+
+static unsigned walk(tlb_t *t, const uint64_t addr) {
+    if (0 == t->p.pwc) return TLB_LEVELS - t->leaf + 1;
+    for (unsigned level = t->leaf + 1; level <= TLB_LEVELS; level++) {
+        uint64_t prefix = addr >> (TLB_BASE_BITS + (level - 1) * TLB_LEVEL_BITS);
+        if (cache_access(&t->pwc, prefix << 2 | (level - 1), 1, false)) return level - t->leaf;
+    }
+    return TLB_LEVELS - t->leaf + 1;
+}
+
+/*
+ * Translate addr for a fetch or a data access. Returns the cycles the
+ * translation adds: none if the first-level TLB hits.
+ */
+
+unsigned tlb_translate(tlb_t *t, const uint64_t addr, const bool fetch) {
+    uint64_t vpn = addr >> t->page_bits;
+    if (cache_access(fetch ? &t->itlb : &t->dtlb, vpn, 1, false)) return 0;
+    unsigned cycles = t->p.stlb_hit;
+    if (!cache_access(&t->stlb, vpn, 1, false)) {
+        unsigned refs = walk(t, addr);
+        t->walks++;
+        t->walk_refs += refs;
+        cycles += refs * t->p.walk;
+    }
+    t->cycles += cycles;
+    return cycles;
+}
@@ -0,0 +1,283 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * trace.c - Writer and reader for the binary instruction/memory trace.
+ *
+ * The writer copies raw records into an in-memory block and only packs
+ * and writes a block when it fills, so the per-instruction cost while
+ * tracing is a struct copy. The file stream is given a large buffer so
+ * that blocks reach the OS in big writes.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "trace.h"
+#include "util.h"
+
+// Pseudo-opcode for a record that only moves the PC delta base.
+#define TR_OP_RESYNC TR_OP_MASK
+// Worst case: header, opcode, register descriptor, two sources, memory
+// descriptor and two 10-byte varints.
+#define TR_MAX_REC_BYTES 26
+
+static FILE *trace_fp;
+static trace_rec_t pending[TRACE_BLOCK_RECS];
+static unsigned num_pending;
+static uint8_t packed[TRACE_BLOCK_RECS * (TR_MAX_REC_BYTES + 11)];
+static trace_stats_t wstats;
+
+static inline uint64_t zigzag(const int64_t v) {return (((uint64_t) v) << 1) ^ (uint64_t) (v >> 63);}
+static inline int64_t unzigzag(const uint64_t v) {return (int64_t) (v >> 1) ^ -(int64_t) (v & 1);}
+
+static inline uint8_t *put_varint(uint8_t *p, uint64_t v) {
+    while (v >= 0x80) {
+        *p++ = (uint8_t) (v | 0x80);
+        v >>= 7;
+    }
+    *p++ = (uint8_t) v;
+    return p;
+}
+
+static inline const uint8_t *get_varint(const uint8_t *p, uint64_t *v) {
+    uint64_t x = 0;
+    unsigned shift = 0;
+    do {
+        x |= ((uint64_t) (*p & 0x7F)) << shift;
+        shift += 7;
+    } while (*p++ & 0x80);
+    *v = x;
+    return p;
+}
+
+static inline unsigned log2_width(const unsigned width) {
+    switch (width) {
+        case 1: return 0;
+        case 2: return 1;
+        case 4: return 2;
+        case 8: return 3;
+        default: assert(false); return 0;
+    }
+}
+
+/*
+ * Pack and write the pending records as one block.
+ */
+
+static void trace_flush(void) {
+    if (0 == num_pending) return;
+    double t0 = now_secs();
+    uint8_t *p = packed;
+    uint64_t pc = pending[0].pc;
+    uint64_t addr = 0;
+    for (unsigned i = 0; i < num_pending; i++) {
+        const trace_rec_t *rec = pending + i;
+        if (rec->pc != pc) {
+            *p++ = TR_OP_RESYNC;
+            p = put_varint(p, zigzag((int64_t) (rec->pc - pc)));
+        }
+        uint8_t hdr = rec->op < TR_OP_EXT ? (uint8_t) rec->op : TR_OP_EXT;
+        if (TRACE_NO_REG != (rec->dst & rec->src1 & rec->src2)) hdr |= TR_HAS_REGS;
+        if (rec->mem_width) hdr |= TR_HAS_MEM;
+        if (rec->next_pc != rec->pc + 4) hdr |= TR_NONSEQ;
+        *p++ = hdr;
+        if (TR_OP_EXT == (hdr & TR_OP_MASK)) *p++ = (uint8_t) rec->op;
+        if (hdr & TR_HAS_REGS) {
+            *p++ = (TRACE_NO_REG == rec->dst ? TR_REG_NONE : rec->dst) |
+                   (TRACE_NO_REG == rec->src1 ? 0 : TR_REG_SRC1) |
+                   (TRACE_NO_REG == rec->src2 ? 0 : TR_REG_SRC2);
+            if (TRACE_NO_REG != rec->src1) *p++ = rec->src1;
+            if (TRACE_NO_REG != rec->src2) *p++ = rec->src2;
+        }
+        if (hdr & TR_HAS_MEM) {
+            *p++ = log2_width(rec->mem_width) | (rec->is_store ? TR_MEM_STORE : 0);
+            p = put_varint(p, zigzag((int64_t) (rec->mem_addr - addr)));
+            addr = rec->mem_addr;
+        }
+        if (hdr & TR_NONSEQ)
+            p = put_varint(p, zigzag((int64_t) (rec->next_pc - rec->pc)));
+        pc = rec->next_pc;
+    }
+    trace_block_hdr_t bh = {num_pending, (uint32_t) (p - packed), pending[0].pc};
+    fwrite(&bh, sizeof(bh), 1, trace_fp);
+    fwrite(packed, 1, bh.nbytes, trace_fp);
+    wstats.num_recs += num_pending;
+    wstats.num_bytes += sizeof(bh) + bh.nbytes;
+    num_pending = 0;
+    wstats.secs += now_secs() - t0;
+}
+
+bool trace_open(const char *path, const uint64_t entry) {
+    assert(NULL == trace_fp);
+    if (NULL == (trace_fp = fopen(path, "wb"))) return false;
+    setvbuf(trace_fp, NULL, _IOFBF, TRACE_IO_BUF_LEN);
+    trace_file_hdr_t fh;
+    memcpy(fh.magic, TRACE_MAGIC, sizeof(fh.magic));
+    fh.entry = entry;
+    fwrite(&fh, sizeof(fh), 1, trace_fp);
+    memset(&wstats, 0, sizeof(wstats));
+    wstats.num_bytes = sizeof(fh);
+    num_pending = 0;
+    return true;
+}
+
+bool trace_is_open(void) {return NULL != trace_fp;}
+
+void trace_write(const trace_rec_t *rec) {
+    pending[num_pending++] = *rec;
+    if (TRACE_BLOCK_RECS == num_pending) trace_flush();
+}
+
+/*
+ * Describe one retired instruction. pc is the address it was fetched from
+ * and next_pc the value of PC after its update-PC stage.
+ */
+
+void trace_fill(trace_rec_t *rec, const instr_t *insn, const uint64_t pc, const uint64_t next_pc) {
+    rec->pc = pc;
+    rec->next_pc = next_pc;
+    rec->op = insn->op;
+    rec->taken = (next_pc != pc + 4);
+    rec->mem_addr = insn->val_ex.xval;
+    switch (insn->op) {
+        case OP_LDURB:  rec->mem_width = 1; rec->is_store = false; break;
+        case OP_LDUR:   rec->mem_width = 8; rec->is_store = false; break;
+        case OP_LDUR_W: rec->mem_width = 4; rec->is_store = false; break;
+        case OP_STURB:  rec->mem_width = 1; rec->is_store = true; break;
+        case OP_STUR:   rec->mem_width = 8; rec->is_store = true; break;
+        case OP_STUR_W: rec->mem_width = 4; rec->is_store = true; break;
+        case OP_LDXR:   rec->mem_width = 8; rec->is_store = false; break;
+        case OP_LDXR_W: rec->mem_width = 4; rec->is_store = false; break;
+        case OP_STXR:   rec->mem_width = 8; rec->is_store = true; break;
+        case OP_STXR_W: rec->mem_width = 4; rec->is_store = true; break;
+        default: rec->mem_width = 0; rec->is_store = false; rec->mem_addr = 0; break;
+    }
+    rec->dst = insn->dst > R_SP ? TRACE_NO_REG : insn->dst; // Of the stores, only STXR writes one.
+    rec->src1 = insn->src1 > R_SP ? TRACE_NO_REG : insn->src1;
+    rec->src2 = insn->src2 > R_SP ? TRACE_NO_REG : insn->src2;
+}
+
+/*
+ * Record one retired instruction, as described by trace_fill.
+ */
+
+void trace_instr(const instr_t *insn, const uint64_t pc, const uint64_t next_pc) {
+    trace_fill(pending + num_pending, insn, pc, next_pc);
+    if (TRACE_BLOCK_RECS == ++num_pending) trace_flush();
+}
+
+void trace_close(trace_stats_t *stats) {
+    if (NULL == trace_fp) return;
+    trace_flush();
+    double t0 = now_secs();
+    fclose(trace_fp);
+    wstats.secs += now_secs() - t0;
+    trace_fp = NULL;
+    if (stats) *stats = wstats;
+}
+
+/*
+ * Map a trace file for reading. The whole file is mapped at once and the
+ * kernel is told that it will be read sequentially.
+ */
+
+bool trace_map_open(trace_map_t *m, const char *path) {
+    memset(m, 0, sizeof(*m));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (0 != fstat(fd, &st) || st.st_size < sizeof(trace_file_hdr_t)) {
+        close(fd);
+        return false;
+    }
+    void *p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (MAP_FAILED == p) return false;
+    madvise(p, st.st_size, MADV_SEQUENTIAL);
+    const trace_file_hdr_t *fh = p;
+    if (0 != memcmp(fh->magic, TRACE_MAGIC, sizeof(fh->magic))) {
+        munmap(p, st.st_size);
+        return false;
+    }
+    m->base = p;
+    m->len = st.st_size;
+    m->entry = fh->entry;
+    return true;
+}
+
+void trace_map_close(trace_map_t *m) {
+    if (m->base) munmap((void *) m->base, m->len);
+    memset(m, 0, sizeof(*m));
+}
+
+void trace_reader_init(trace_reader_t *r, const trace_map_t *m) {
+    memset(r, 0, sizeof(*r));
+    r->map = m;
+    r->off = sizeof(trace_file_hdr_t);
+}
+
+static bool trace_next_block(trace_reader_t *r) {
+    trace_block_hdr_t bh;
+    if (r->off + sizeof(bh) > r->map->len) return false;
+    memcpy(&bh, r->map->base + r->off, sizeof(bh));
+    r->off += sizeof(bh);
+    if (r->off + bh.nbytes > r->map->len) return false;
+    r->cur = r->map->base + r->off;
+    r->off += bh.nbytes;
+    r->left = bh.nrecs;
+    r->pc = bh.first_pc;
+    r->addr = 0;
+    return true;
+}
+
+bool trace_next(trace_reader_t *r, trace_rec_t *rec) {
+    if (0 == r->left && !trace_next_block(r)) return false;
+    uint64_t v;
+    uint8_t hdr = *r->cur++;
+    if (TR_OP_RESYNC == (hdr & TR_OP_MASK)) {
+        r->cur = get_varint(r->cur, &v);
+        r->pc += unzigzag(v);
+        hdr = *r->cur++;
+    }
+    rec->pc = r->pc;
+    rec->op = (opcode_t) (hdr & TR_OP_MASK);
+    if (TR_OP_EXT == rec->op) rec->op = (opcode_t) *r->cur++;
+    rec->dst = rec->src1 = rec->src2 = TRACE_NO_REG;
+    if (hdr & TR_HAS_REGS) {
+        uint8_t rd = *r->cur++;
+        if (TR_REG_NONE != (rd & TR_REG_MASK)) rec->dst = rd & TR_REG_MASK;
+        if (rd & TR_REG_SRC1) rec->src1 = *r->cur++;
+        if (rd & TR_REG_SRC2) rec->src2 = *r->cur++;
+    }
+    if (hdr & TR_HAS_MEM) {
+        uint8_t md = *r->cur++;
+        rec->mem_width = 1 << (md & TR_MEM_LOG2W_MASK);
+        rec->is_store = md & TR_MEM_STORE;
+        r->cur = get_varint(r->cur, &v);
+        r->addr += unzigzag(v);
+        rec->mem_addr = r->addr;
+    } else {
+        rec->mem_width = 0;
+        rec->is_store = false;
+        rec->mem_addr = 0;
+    }
+    if (hdr & TR_NONSEQ) {
+        r->cur = get_varint(r->cur, &v);
+        rec->next_pc = rec->pc + unzigzag(v);
+    } else rec->next_pc = rec->pc + 4;
+    rec->taken = (hdr & TR_NONSEQ);
+    r->pc = rec->next_pc;
+    r->left--;
+    return true;
+}
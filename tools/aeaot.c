@@ -0,0 +1,365 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * aeaot.c - Ahead-of-time translator from a guest ELF executable to C.
+ *
+ * Usage: aeaot [-o out.c] executable
+ *
+ * Loads the executable with loadElf and discovers code by following
+ * control flow from the entry point and from every function symbol. Each
+ * guest function (entry, symbol or BL target) becomes a C function with a
+ * label per basic block, so that direct branches are gotos and BL is a C
+ * call. Only the control flow is translated. Every other instruction
+ * becomes a call to its step_<op> function (instr.c), which runs it
+ * through the handlers instr_spec.h names for it, so there is one
+ * definition of each instruction for ae, the JIT's side exits and native
+ * binaries alike.
+ *
+ * A C function takes the guest PC to start at and returns the guest
+ * PC to continue at: normally the return address its RET read from X30.
+ * When a RET goes anywhere else, the caller returns too and aot_dispatch,
+ * a table of every block, picks up from there. Code that was not
+ * discovered, and HLT, runs in the interpreter. The loadable segments are
+ * embedded so that the native binary needs nothing else.
+ *
+ * The C is linked with aot_rt.c and the simulator sources (for mem.c and
+ * the interpreter) into a native binary; see the native target in the
+ * Makefile. Translated guests run to completion: there is no instruction
+ * budget, and no instruction count either, so the instruction and cycle
+ * counters of the counter device (mmio.h) read 0.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <elf.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "archsim.h"
+
+// Marks on each word of the text segment.
+#define M_SEEN   0x1    // Decoded during discovery.
+#define M_LEADER 0x2    // Starts a basic block.
+#define M_FUNC   0x4    // Starts a function.
+
+static uint64_t text_lo, text_hi;
+static uint8_t *marks;
+static unsigned *owner;     // Function (index + 1) that aot_dispatch sends each block to.
+static unsigned *visit;     // Function (index + 1) that last collected each block.
+
+static uint64_t *work, *funcs, *blocks;
+static unsigned num_work, num_funcs, num_blocks;
+static const char **func_names;
+
+static FILE *out;
+
+// Opcode identifiers, for naming step_<op>.
+static const char *const op_ids[] = {
+#define INSTR(op, name, mask, value, is_32, fmt, ex, mem, wb, upc) [OP_##op] = #op,
+#include "instr_spec.h"
+#undef INSTR
+};
+
+static inline bool in_text(const uint64_t pc) {return pc >= text_lo && pc < text_hi && !(pc & 3);}
+static inline unsigned word(const uint64_t pc) {return (pc - text_lo) >> 2;}
+static inline bool is_leader(const uint64_t pc) {return in_text(pc) && (marks[word(pc)] & M_LEADER);}
+
+static opcode_t op_at(const uint64_t pc, int32_t *instr) {
+    *instr = mem_read_I(pc);
+    opcode_t op = lookup_op(*instr);
+    if (OP_ASR == op && 0x3FU != GETBF(*instr, 10, 6)) return OP_ERROR; // Only the ASR alias of SBFM.
+    if (OP_ASR_W == op && 0x1FU != GETBF(*instr, 10, 6)) return OP_ERROR;
+    return op;
+}
+
+// Left to the interpreter.
+static inline bool is_translatable(const opcode_t op) {return OP_ERROR != op && OP_HLT != op;}
+
+static inline int64_t sext(const uint64_t v, const unsigned width) {
+    return ((int64_t) (v << (64 - width))) >> (64 - width);
+}
+
+/*
+ * Discovery.
+ */
+
+static void add_leader(const uint64_t pc, const bool func) {
+    int32_t instr;
+    if (!in_text(pc) || !is_translatable(op_at(pc, &instr))) return;
+    uint8_t *m = marks + word(pc);
+    if (func && !(*m & M_FUNC)) {
+        *m |= M_FUNC;
+        funcs[num_funcs++] = pc;
+    }
+    if (!(*m & M_LEADER)) {
+        *m |= M_LEADER;
+        blocks[num_blocks++] = pc;
+        work[num_work++] = pc;
+    }
+}
+
+static void discover(void) {
+    while (num_work) {
+        for (uint64_t pc = work[--num_work]; in_text(pc) && !(marks[word(pc)] & M_SEEN); pc += 4) {
+            int32_t instr;
+            opcode_t op = op_at(pc, &instr);
+            marks[word(pc)] |= M_SEEN;
+            if (!is_translatable(op)) break;
+            if (OP_B == op) {add_leader(pc + sext(GETBF(instr, 0, 26), 26) * 4, false); break;}
+            if (OP_BL == op) {
+                add_leader(pc + sext(GETBF(instr, 0, 26), 26) * 4, true);
+                add_leader(pc + 4, false);
+                break;
+            }
+            if (OP_B_COND == op) {
+                add_leader(pc + sext(GETBF(instr, 5, 19), 19) * 4, false);
+                add_leader(pc + 4, false);
+                break;
+            }
+            if (OP_RET == op) break;
+        }
+    }
+}
+
+/*
+ * Emitting C.
+ */
+
+static void emit_goto(const uint64_t target) {
+    if (is_leader(target)) fprintf(out, "goto L_%lx;\n", target);
+    else fprintf(out, "return 0x%lxULL;\n", target);
+}
+
+/*
+ * Emit one basic block and return the number of successors stored in succ.
+ */
+
+static unsigned emit_block(const uint64_t start, uint64_t succ[2]) {
+    fprintf(out, "L_%lx:\n", start);
+    for (uint64_t pc = start;; pc += 4) {
+        if (pc != start && is_leader(pc)) {
+            fprintf(out, "    ");
+            emit_goto(pc);
+            succ[0] = pc;
+            return 1;
+        }
+        int32_t instr;
+        opcode_t op = op_at(pc, &instr);
+        switch (op) {
+            case OP_B:
+                succ[0] = pc + sext(GETBF(instr, 0, 26), 26) * 4;
+                fprintf(out, "    ");
+                emit_goto(succ[0]);
+                return 1;
+            case OP_B_COND: {
+                cond_t cond = GETBF(instr, 0, 4);
+                succ[0] = pc + sext(GETBF(instr, 5, 19), 19) * 4;
+                succ[1] = pc + 4;
+                if (cond >= C_AL) {
+                    fprintf(out, "    ");
+                    emit_goto(succ[0]);
+                    return 1;
+                }
+                fprintf(out, "    if (cond_holds(%d)) ", cond);
+                emit_goto(succ[0]);
+                fprintf(out, "    ");
+                emit_goto(succ[1]);
+                return 2;
+            }
+            case OP_BL: {
+                uint64_t target = pc + sext(GETBF(instr, 0, 26), 26) * 4;
+                fprintf(out, "    R[R_PC].xval = 0x%lxULL; step_BL(0x%08xU);\n", pc, (uint32_t) instr);
+                if (!in_text(target) || !(marks[word(target)] & M_FUNC)) {
+                    fprintf(out, "    return 0x%lxULL;\n", target); // Left to the interpreter.
+                    return 0;
+                }
+                fprintf(out, "    {uint64_t next = f_%lx(0x%lxULL); if (0x%lxULL != next) return next;}\n",
+                        target, target, pc + 4);
+                succ[0] = pc + 4;
+                fprintf(out, "    ");
+                emit_goto(succ[0]);
+                return 1;
+            }
+            case OP_RET:
+                fprintf(out, "    return R[%u].xval;\n", REG_SRC(GETBF(instr, 5, 5), false));
+                return 0;
+            default:
+                if (!is_translatable(op)) {
+                    fprintf(out, "    return 0x%lxULL; // Interpreted.\n", pc);
+                    return 0;
+                }
+                fprintf(out, "    step_%s(0x%08xU);\n", op_ids[op], (uint32_t) instr);
+                break;
+        }
+    }
+}
+
+static void emit_function(const unsigned f) {
+    uint64_t entry = funcs[f];
+    uint64_t *fblocks = malloc(num_blocks * sizeof(uint64_t));
+    unsigned nfblocks = 0;
+    FILE *file_out = out;
+    char *body;
+    size_t body_len;
+
+    // Collect the blocks reachable from entry without following calls.
+    fblocks[nfblocks++] = entry;
+    visit[word(entry)] = f + 1;
+    out = open_memstream(&body, &body_len);
+    for (unsigned i = 0; i < nfblocks; i++) {
+        uint64_t succ[2];
+        unsigned nsucc = emit_block(fblocks[i], succ);
+        if (!owner[word(fblocks[i])] || fblocks[i] == entry) owner[word(fblocks[i])] = f + 1;
+        for (unsigned s = 0; s < nsucc; s++) {
+            if (!is_leader(succ[s]) || f + 1 == visit[word(succ[s])]) continue;
+            visit[word(succ[s])] = f + 1;
+            fblocks[nfblocks++] = succ[s];
+        }
+    }
+
+    // The body is emitted first so that its blocks are known for the prologue.
+    fclose(out);
+    out = file_out;
+    fprintf(out, "\n// %s\nstatic uint64_t f_%lx(const uint64_t pc) {\n", func_names[f], entry);
+    fprintf(out, "    gpregval_t *const R = guest.proc->regs;\n");
+    fprintf(out, "    switch (pc) {\n");
+    for (unsigned i = 0; i < nfblocks; i++) fprintf(out, "        case 0x%lxULL: goto L_%lx;\n", fblocks[i], fblocks[i]);
+    fprintf(out, "        default: return aot_interpret(pc);\n    }\n");
+    fwrite(body, 1, body_len, out);
+    fprintf(out, "}\n");
+    free(body);
+    free(fblocks);
+}
+
+/*
+ * The ELF file, for what loadElf does not keep: segment extents and symbols.
+ */
+
+static void scan_elf(const char *file, const uint64_t entry) {
+    int fd = open(file, O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        perror(file);
+        exit(EXIT_FAILURE);
+    }
+    uint8_t *base = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (MAP_FAILED == base) {
+        perror("mmap");
+        exit(EXIT_FAILURE);
+    }
+    Elf64_Ehdr *eh = (Elf64_Ehdr *) base;
+    Elf64_Phdr *ph = (Elf64_Phdr *) (base + eh->e_phoff);
+
+    // Text extent, and the segments to embed.
+    unsigned nsegs = 0;
+    text_lo = text_hi = 0;
+    fprintf(out, "#include \"aot.h\"\n");
+    for (unsigned i = 0; i < eh->e_phnum; i++) {
+        if (PT_LOAD != ph[i].p_type) continue;
+        if ((ph[i].p_flags & PF_X) && entry >= ph[i].p_vaddr && entry < ph[i].p_vaddr + ph[i].p_filesz) {
+            text_lo = ph[i].p_vaddr;
+            text_hi = ph[i].p_vaddr + ph[i].p_filesz;
+        }
+        fprintf(out, "\nstatic const uint8_t seg%u[] = {", nsegs++);
+        for (uint64_t j = 0; j < ph[i].p_filesz; j++)
+            fprintf(out, "%s0x%02x,", j % 16 ? " " : "\n    ", (uint8_t) mem_read_B(ph[i].p_vaddr + j));
+        fprintf(out, "\n};\n");
+    }
+    fprintf(out, "\nconst aot_seg_t aot_segs[] = {\n");
+    for (unsigned i = 0, s = 0; i < eh->e_phnum; i++)
+        if (PT_LOAD == ph[i].p_type) {
+            fprintf(out, "    {0x%lxULL, %lu, seg%u},\n", ph[i].p_vaddr, ph[i].p_filesz, s);
+            s++;
+        }
+    fprintf(out, "};\nconst unsigned aot_num_segs = %u;\nconst uint64_t aot_entry = 0x%lxULL;\n", nsegs, entry);
+    if (text_hi == text_lo) {
+        fprintf(stderr, "%s: entry point is not in an executable segment\n", file);
+        exit(EXIT_FAILURE);
+    }
+
+    size_t nwords = (text_hi - text_lo) / 4 + 1;
+    marks = calloc(nwords, 1);
+    owner = calloc(nwords, sizeof(unsigned));
+    visit = calloc(nwords, sizeof(unsigned));
+    work = malloc(nwords * sizeof(uint64_t));
+    funcs = malloc(nwords * sizeof(uint64_t));
+    blocks = malloc(nwords * sizeof(uint64_t));
+    func_names = calloc(nwords, sizeof(char *));
+
+    add_leader(entry, true);
+    func_names[0] = "entry";
+
+    // Function symbols.
+    Elf64_Shdr *sh = (Elf64_Shdr *) (base + eh->e_shoff);
+    for (unsigned i = 0; eh->e_shoff && i < eh->e_shnum; i++) {
+        if (SHT_SYMTAB != sh[i].sh_type) continue;
+        Elf64_Sym *syms = (Elf64_Sym *) (base + sh[i].sh_offset);
+        const char *strtab = (const char *) (base + sh[sh[i].sh_link].sh_offset);
+        for (unsigned j = 0; j < sh[i].sh_size / sizeof(Elf64_Sym); j++) {
+            if (STT_FUNC != ELF64_ST_TYPE(syms[j].st_info)) continue;
+            unsigned before = num_funcs;
+            add_leader(syms[j].st_value, true);
+            if (num_funcs > before) func_names[before] = strdup(strtab + syms[j].st_name);
+            else if (syms[j].st_value == entry) func_names[0] = strdup(strtab + syms[j].st_name);
+        }
+    }
+    munmap(base, st.st_size);
+    close(fd);
+}
+
+int main(int argc, char *argv[]) {
+    char *out_file = NULL;
+    int option;
+    while ((option = getopt(argc, argv, "o:")) != -1) {
+        switch (option) {
+            case 'o': out_file = optarg; break;
+            default:
+                fprintf(stderr, "Usage: %s [-o out.c] executable\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "Usage: %s [-o out.c] executable\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+    infile = stdin;
+    outfile = stdout;
+    errfile = stderr;
+    init_machine("AArch64", 64, L_ENDIAN, L_ENDIAN);
+    init_itable();
+    uint64_t entry = loadElf(argv[optind]);
+
+    out = out_file ? fopen(out_file, "w") : stdout;
+    if (NULL == out) {
+        perror(out_file);
+        return EXIT_FAILURE;
+    }
+    scan_elf(argv[optind], entry);
+    discover();
+    for (unsigned f = 0; f < num_funcs; f++)
+        if (NULL == func_names[f]) func_names[f] = "BL target";
+
+    fprintf(out, "\n");
+    for (unsigned f = 0; f < num_funcs; f++) fprintf(out, "static uint64_t f_%lx(const uint64_t);\n", funcs[f]);
+    for (unsigned f = 0; f < num_funcs; f++) emit_function(f);
+
+    fprintf(out, "\nuint64_t aot_dispatch(const uint64_t pc) {\n    switch (pc) {\n");
+    for (unsigned i = 0; i < num_blocks; i++)
+        if (owner[word(blocks[i])])
+            fprintf(out, "        case 0x%lxULL: return f_%lx(pc);\n", blocks[i], funcs[owner[word(blocks[i])] - 1]);
+    fprintf(out, "        default: return aot_interpret(pc);\n    }\n}\n");
+
+    if (fclose(out) != 0) {
+        perror(out_file);
+        return EXIT_FAILURE;
+    }
+    fprintf(stderr, "%s: %u functions, %u blocks\n", argv[optind], num_funcs, num_blocks);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,142 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * aereplay.c - Drive timing models from a recorded trace.
+ *
+ * Usage: aereplay [-j threads] [-c config]... [-f configfile] tracefile
+ *   -j  number of worker threads (default: number of online CPUs).
+ *   -c  a model configuration line (see timing.h); may be repeated.
+ *   -f  a file of configuration lines; blank lines and # comments skipped.
+ *
+ * The trace is mapped once and shared. Configurations are dealt out to the
+ * worker threads round-robin; each thread decodes the trace once and feeds
+ * every record to all of its models. One report line per configuration is
+ * printed, in the order the configurations were given.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include "trace.h"
+#include "timing.h"
+#include "util.h"
+
+#define MAX_LINE_LEN 256
+
+typedef struct worker {
+    pthread_t   tid;
+    const trace_map_t *map;
+    timing_model_t **models;
+    unsigned    num_models;
+    uint64_t    num_recs;
+} worker_t;
+
+static timing_model_t **models;
+static unsigned num_models, cap_models;
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-j threads] [-c config]... [-f configfile] tracefile\n", prog);
+    exit(EXIT_FAILURE);
+}
+
+static void add_model(const char *config) {
+    timing_model_t *m = timing_model_create(config);
+    if (NULL == m) {
+        fprintf(stderr, "Bad model configuration: %s\n", config);
+        exit(EXIT_FAILURE);
+    }
+    if (num_models == cap_models) {
+        cap_models = cap_models ? 2 * cap_models : 16;
+        models = realloc(models, cap_models * sizeof(timing_model_t *));
+    }
+    models[num_models++] = m;
+}
+
+static void add_model_file(const char *path) {
+    char line[MAX_LINE_LEN];
+    FILE *fp = fopen(path, "r");
+    if (NULL == fp) {
+        perror(path);
+        exit(EXIT_FAILURE);
+    }
+    while (fgets(line, sizeof(line), fp)) {
+        char *s = line + strspn(line, " \t");
+        if ('#' == *s || '\n' == *s || '\0' == *s) continue;
+        add_model(s);
+    }
+    fclose(fp);
+}
+
+static void *run_worker(void *arg) {
+    worker_t *w = arg;
+    trace_reader_t r;
+    trace_rec_t rec;
+    trace_reader_init(&r, w->map);
+    while (trace_next(&r, &rec)) {
+        for (unsigned i = 0; i < w->num_models; i++)
+            timing_model_consume(w->models[i], &rec);
+        w->num_recs++;
+    }
+    return NULL;
+}
+
+int main(int argc, char *argv[]) {
+    long num_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int option;
+    while ((option = getopt(argc, argv, "j:c:f:")) != -1) {
+        switch (option) {
+            case 'j': num_threads = atol(optarg); break;
+            case 'c': add_model(optarg); break;
+            case 'f': add_model_file(optarg); break;
+            default: usage(argv[0]); break;
+        }
+    }
+    if (optind >= argc || 0 == num_models) usage(argv[0]);
+    if (num_threads < 1) num_threads = 1;
+    if (num_threads > num_models) num_threads = num_models;
+
+    trace_map_t map;
+    if (!trace_map_open(&map, argv[optind])) {
+        fprintf(stderr, "%s: not a readable trace\n", argv[optind]);
+        return EXIT_FAILURE;
+    }
+
+    worker_t *workers = calloc(num_threads, sizeof(worker_t));
+    for (long t = 0; t < num_threads; t++) {
+        workers[t].map = &map;
+        workers[t].models = calloc(num_models, sizeof(timing_model_t *));
+    }
+    for (unsigned i = 0; i < num_models; i++) {
+        worker_t *w = workers + i % num_threads;
+        w->models[w->num_models++] = models[i];
+    }
+
+    double t0 = now_secs();
+    for (long t = 0; t < num_threads; t++)
+        pthread_create(&workers[t].tid, NULL, run_worker, workers + t);
+    for (long t = 0; t < num_threads; t++)
+        pthread_join(workers[t].tid, NULL);
+    double secs = now_secs() - t0;
+
+    for (unsigned i = 0; i < num_models; i++) {
+        timing_model_report(models[i], stdout);
+        timing_model_free(models[i]);
+    }
+    uint64_t recs = workers[0].num_recs;
+    fprintf(stderr, "Replayed %lu records into %u configurations on %ld threads in %.3fs (%.1f M model-records/s)\n",
+            recs, num_models, num_threads, secs, secs > 0 ? recs * num_models / secs / 1e6 : 0.0);
+
+    for (long t = 0; t < num_threads; t++) free(workers[t].models);
+    free(workers);
+    free(models);
+    trace_map_close(&map);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,306 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * aesimpoint.c - Pick representative intervals from basic-block vectors.
+ *
+ * Usage: aesimpoint [-k maxk] [-d dims] [-r restarts] [-s seed] bbvfile
+ *   -k  largest number of clusters to try (default 10).
+ *   -d  dimensions to project the vectors down to (default 15).
+ *   -r  random restarts of k-means for each k (default 5).
+ *   -s  random seed (default 1), so that results are repeatable.
+ *
+ * Reads the .bb file ae writes with -V (see bbv.h) and follows SimPoint:
+ * each vector is normalized to sum to 1 and randomly projected to a few
+ * dimensions, then clustered with k-means for k = 1 .. maxk. The k chosen
+ * is the smallest whose BIC score is within 90% of the best seen. For
+ * each cluster the interval nearest its centroid stands for it, weighted
+ * by the fraction of intervals in the cluster. One line is printed per
+ * representative,
+ *
+ *     <interval> <weight>
+ *
+ * in interval order, counting from 0. To simulate interval i with a warm-up
+ * of W instructions, run
+ *
+ *     ae -f (i*I - W) -w W -b (i+1)*I -m <model> ... executable
+ *
+ * where I is the interval length the profile was taken with; the weighted
+ * sum of the intervals' CPIs estimates the CPI of the whole run.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+#include <float.h>
+#include <math.h>
+
+#define MAX_ITERS 100
+#define BIC_FRACTION 0.9
+
+typedef struct bb_entry {
+    unsigned    id;
+    uint64_t    count;
+} bb_entry_t;
+
+typedef struct bb_vector {
+    bb_entry_t  *entries;
+    unsigned    num_entries;
+    uint64_t    total;
+} bb_vector_t;
+
+typedef struct clustering {
+    unsigned    k;
+    unsigned    *assign;    // Cluster of each point.
+    double      *centers;   // k rows of dims.
+    double      distortion; // Sum of squared distances to the centers.
+    double      bic;
+} clustering_t;
+
+static bb_vector_t *vecs;
+static unsigned num_vecs, cap_vecs, max_id;
+static unsigned dims = 15;
+static double *points;      // num_vecs rows of dims.
+static uint64_t rng_state = 1;
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-k maxk] [-d dims] [-r restarts] [-s seed] bbvfile\n", prog);
+    exit(EXIT_FAILURE);
+}
+
+// xorshift64*: repeatable across hosts, unlike rand().
+static uint64_t rng_next(void) {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return rng_state * 0x2545F4914F6CDD1DULL;
+}
+
+static double rng_uniform(void) {return (rng_next() >> 11) * (1.0 / 9007199254740992.0);}
+
+/*
+ * Read one vector per line starting with T; other lines are skipped.
+ */
+
+static bool read_bbv(const char *path) {
+    FILE *fp = fopen(path, "r");
+    if (NULL == fp) return false;
+    char *line = NULL;
+    size_t len = 0;
+    while (getline(&line, &len, fp) > 0) {
+        if ('T' != line[0]) continue;
+        if (num_vecs == cap_vecs) {
+            cap_vecs = cap_vecs ? 2 * cap_vecs : 256;
+            vecs = realloc(vecs, cap_vecs * sizeof(bb_vector_t));
+        }
+        bb_vector_t *v = vecs + num_vecs++;
+        unsigned cap = 0;
+        memset(v, 0, sizeof(*v));
+        unsigned id;
+        uint64_t count;
+        int used;
+        for (char *s = line + 1; 2 == sscanf(s, " :%u:%lu%n", &id, &count, &used); s += used) {
+            if (v->num_entries == cap) {
+                cap = cap ? 2 * cap : 16;
+                v->entries = realloc(v->entries, cap * sizeof(bb_entry_t));
+            }
+            v->entries[v->num_entries++] = (bb_entry_t) {id, count};
+            v->total += count;
+            if (id > max_id) max_id = id;
+        }
+    }
+    free(line);
+    fclose(fp);
+    return true;
+}
+
+/*
+ * Normalize each vector and project it through a random matrix with
+ * entries uniform in [-1, 1].
+ */
+
+static void project(void) {
+    double *proj = malloc((size_t) (max_id + 1) * dims * sizeof(double));
+    for (size_t i = 0; i < (size_t) (max_id + 1) * dims; i++) proj[i] = 2.0 * rng_uniform() - 1.0;
+    points = calloc((size_t) num_vecs * dims, sizeof(double));
+    for (unsigned i = 0; i < num_vecs; i++) {
+        bb_vector_t *v = vecs + i;
+        for (unsigned e = 0; e < v->num_entries; e++) {
+            double w = (double) v->entries[e].count / v->total;
+            for (unsigned d = 0; d < dims; d++)
+                points[i * dims + d] += w * proj[v->entries[e].id * dims + d];
+        }
+    }
+    free(proj);
+}
+
+static inline double dist2(const double *a, const double *b) {
+    double s = 0.0;
+    for (unsigned d = 0; d < dims; d++) s += (a[d] - b[d]) * (a[d] - b[d]);
+    return s;
+}
+
+/*
+ * One run of k-means from k-means++ seeds. Fills in c->assign, c->centers
+ * and c->distortion.
+ */
+
+static void kmeans(clustering_t *c) {
+    unsigned k = c->k;
+    double *best = malloc(num_vecs * sizeof(double));
+    unsigned *sizes = malloc(k * sizeof(unsigned));
+
+    memcpy(c->centers, points + (rng_next() % num_vecs) * dims, dims * sizeof(double));
+    for (unsigned i = 0; i < num_vecs; i++) best[i] = dist2(points + i * dims, c->centers);
+    for (unsigned j = 1; j < k; j++) {
+        double sum = 0.0;
+        for (unsigned i = 0; i < num_vecs; i++) sum += best[i];
+        double r = rng_uniform() * sum;
+        unsigned pick = num_vecs - 1;
+        for (unsigned i = 0; i < num_vecs; i++)
+            if ((r -= best[i]) <= 0.0) {pick = i; break;}
+        memcpy(c->centers + j * dims, points + pick * dims, dims * sizeof(double));
+        for (unsigned i = 0; i < num_vecs; i++) {
+            double d = dist2(points + i * dims, c->centers + j * dims);
+            if (d < best[i]) best[i] = d;
+        }
+    }
+
+    for (unsigned iter = 0; iter < MAX_ITERS; iter++) {
+        bool changed = false;
+        c->distortion = 0.0;
+        for (unsigned i = 0; i < num_vecs; i++) {
+            unsigned arg = 0;
+            double min = DBL_MAX;
+            for (unsigned j = 0; j < k; j++) {
+                double d = dist2(points + i * dims, c->centers + j * dims);
+                if (d < min) {min = d; arg = j;}
+            }
+            if (0 == iter || c->assign[i] != arg) changed = true;
+            c->assign[i] = arg;
+            c->distortion += min;
+        }
+        if (!changed) break;
+        memset(c->centers, 0, k * dims * sizeof(double));
+        memset(sizes, 0, k * sizeof(unsigned));
+        for (unsigned i = 0; i < num_vecs; i++) {
+            sizes[c->assign[i]]++;
+            for (unsigned d = 0; d < dims; d++) c->centers[c->assign[i] * dims + d] += points[i * dims + d];
+        }
+        for (unsigned j = 0; j < k; j++)
+            for (unsigned d = 0; d < dims; d++)
+                if (sizes[j]) c->centers[j * dims + d] /= sizes[j];
+    }
+    free(best);
+    free(sizes);
+}
+
+/*
+ * Bayesian information criterion of a clustering, treating the clusters
+ * as spherical Gaussians with a shared variance (Pelleg and Moore's
+ * X-means, as used by SimPoint).
+ */
+
+static double bic(const clustering_t *c) {
+    double R = num_vecs, M = dims, K = c->k;
+    if (R <= K) return -DBL_MAX;
+    double var = c->distortion / (M * (R - K));
+    if (var < 1e-300) var = 1e-300;
+    unsigned *sizes = calloc(c->k, sizeof(unsigned));
+    for (unsigned i = 0; i < num_vecs; i++) sizes[c->assign[i]]++;
+    double ll = -R * M / 2.0 * log(2.0 * M_PI * var) - M * (R - K) / 2.0;
+    for (unsigned j = 0; j < c->k; j++)
+        if (sizes[j]) ll += sizes[j] * log(sizes[j] / R);
+    free(sizes);
+    double params = K * (M + 1.0);
+    return ll - params / 2.0 * log(R);
+}
+
+int main(int argc, char *argv[]) {
+    unsigned max_k = 10, restarts = 5;
+    int option;
+    while ((option = getopt(argc, argv, "k:d:r:s:")) != -1) {
+        switch (option) {
+            case 'k': max_k = atoi(optarg); break;
+            case 'd': dims = atoi(optarg); break;
+            case 'r': restarts = atoi(optarg); break;
+            case 's': rng_state = strtoull(optarg, NULL, 0); break;
+            default: usage(argv[0]); break;
+        }
+    }
+    if (optind >= argc || 0 == max_k || 0 == dims || 0 == restarts) usage(argv[0]);
+    if (0 == rng_state) rng_state = 1;
+    if (!read_bbv(argv[optind]) || 0 == num_vecs) {
+        fprintf(stderr, "%s: no basic-block vectors\n", argv[optind]);
+        return EXIT_FAILURE;
+    }
+    if (max_k > num_vecs) max_k = num_vecs;
+    project();
+
+    // The best of the restarts for each k.
+    clustering_t *runs = calloc(max_k + 1, sizeof(clustering_t));
+    clustering_t trial;
+    trial.assign = malloc(num_vecs * sizeof(unsigned));
+    trial.centers = malloc((size_t) max_k * dims * sizeof(double));
+    double lo = DBL_MAX, hi = -DBL_MAX;
+    for (unsigned k = 1; k <= max_k; k++) {
+        clustering_t *c = runs + k;
+        c->k = trial.k = k;
+        c->assign = malloc(num_vecs * sizeof(unsigned));
+        c->centers = malloc((size_t) k * dims * sizeof(double));
+        c->distortion = DBL_MAX;
+        for (unsigned r = 0; r < restarts; r++) {
+            kmeans(&trial);
+            if (trial.distortion >= c->distortion) continue;
+            c->distortion = trial.distortion;
+            memcpy(c->assign, trial.assign, num_vecs * sizeof(unsigned));
+            memcpy(c->centers, trial.centers, (size_t) k * dims * sizeof(double));
+        }
+        c->bic = bic(c);
+        if (c->bic > -DBL_MAX && c->bic < lo) lo = c->bic;
+        if (c->bic > hi) hi = c->bic;
+    }
+    unsigned pick = 1;
+    while (pick < max_k && runs[pick].bic < lo + BIC_FRACTION * (hi - lo)) pick++;
+    clustering_t *c = runs + pick;
+
+    // The interval nearest each centroid represents its cluster.
+    unsigned *rep = malloc(pick * sizeof(unsigned)), *sizes = calloc(pick, sizeof(unsigned));
+    double *near = malloc(pick * sizeof(double));
+    for (unsigned j = 0; j < pick; j++) near[j] = DBL_MAX;
+    for (unsigned i = 0; i < num_vecs; i++) {
+        unsigned j = c->assign[i];
+        double d = dist2(points + i * dims, c->centers + j * dims);
+        sizes[j]++;
+        if (d < near[j]) {near[j] = d; rep[j] = i;}
+    }
+    unsigned num_reps = 0;
+    for (unsigned i = 0; i < num_vecs; i++)
+        for (unsigned j = 0; j < pick; j++)
+            if (sizes[j] && rep[j] == i) {
+                printf("%u %.6f\n", i, (double) sizes[j] / num_vecs);
+                num_reps++;
+            }
+    fprintf(stderr, "%u intervals, %u blocks: chose k=%u (BIC %.1f, range %.1f .. %.1f), %u representatives\n",
+            num_vecs, max_id, pick, c->bic, lo, hi, num_reps);
+
+    for (unsigned k = 1; k <= max_k; k++) {
+        free(runs[k].assign);
+        free(runs[k].centers);
+    }
+    free(runs);
+    free(trial.assign);
+    free(trial.centers);
+    free(rep);
+    free(sizes);
+    free(near);
+    free(points);
+    for (unsigned i = 0; i < num_vecs; i++) free(vecs[i].entries);
+    free(vecs);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * aetrace.c - Dump or summarize a binary trace written by ae -t.
+ *
+ * Usage: aetrace [-s] tracefile
+ *   -s  print only a per-opcode summary instead of every record.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <unistd.h>
+#include "trace.h"
+#include "util.h"
+
+static char *opcode_names[] = {
+    "ERR",
+#define INSTR(op, name, mask, value, is_32, fmt, ex, mem, wb, upc) name,
+#include "instr_spec.h"
+#undef INSTR
+};
+
+#define NUM_OPS ((int) (sizeof(opcode_names) / sizeof(opcode_names[0])))
+
+static const char *op_name(const opcode_t op) {
+    return (op >= 0 && op < NUM_OPS) ? opcode_names[op] : "???";
+}
+
+int main(int argc, char *argv[]) {
+    bool summary = false;
+    int option;
+    while ((option = getopt(argc, argv, "s")) != -1) {
+        switch (option) {
+            case 's': summary = true; break;
+            default:
+                fprintf(stderr, "Usage: %s [-s] tracefile\n", argv[0]);
+                return EXIT_FAILURE;
+        }
+    }
+    if (optind >= argc) {
+        fprintf(stderr, "Usage: %s [-s] tracefile\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    trace_map_t m;
+    trace_reader_t r;
+    if (!trace_map_open(&m, argv[optind])) {
+        fprintf(stderr, "%s: not a readable trace\n", argv[optind]);
+        return EXIT_FAILURE;
+    }
+    trace_reader_init(&r, &m);
+
+    trace_rec_t rec;
+    uint64_t num = 0, loads = 0, stores = 0, taken = 0;
+    uint64_t counts[NUM_OPS] = {0};
+    while (trace_next(&r, &rec)) {
+        num++;
+        if (rec.op >= 0 && rec.op < NUM_OPS) counts[rec.op]++;
+        if (rec.mem_width) {
+            if (rec.is_store) stores++;
+            else loads++;
+        }
+        if (rec.taken) taken++;
+        if (summary) continue;
+        printf("%08lX  %-7s", rec.pc, op_name(rec.op));
+        if (TRACE_NO_REG != rec.dst) printf("  R%-2u", rec.dst);
+        else printf("     ");
+        if (TRACE_NO_REG != rec.src1) printf("  R%-2u", rec.src1);
+        else printf("     ");
+        if (TRACE_NO_REG != rec.src2) printf("  R%-2u", rec.src2);
+        else printf("     ");
+        if (rec.mem_width)
+            printf("  %c%u[%016lX]", rec.is_store ? 'W' : 'R', rec.mem_width, rec.mem_addr);
+        if (rec.taken) printf("  -> %08lX", rec.next_pc);
+        printf("\n");
+    }
+    printf("%lu instrs, %lu loads, %lu stores, %lu taken, %lu bytes (%.2f bytes/instr)\n",
+           num, loads, stores, taken, m.len, ratio(m.len, num));
+    trace_map_close(&m);
+    if (summary) {
+        for (int i = 0; i < NUM_OPS; i++)
+            if (counts[i]) printf("  %-7s %12lu\n", opcode_names[i], counts[i]);
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,38 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * aot.h - Interface between C emitted by aeaot and its runtime (aot_rt.c).
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#ifndef _AOT_H_
+#define _AOT_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "machine.h"
+#include "instr.h"
+#include "instructions.h"
+
+// A loadable segment of the guest image.
+typedef struct aot_seg {
+    uint64_t        vaddr;
+    uint64_t        size;
+    const uint8_t   *data;
+} aot_seg_t;
+
+// Provided by the emitted C.
+extern const aot_seg_t aot_segs[];
+extern const unsigned aot_num_segs;
+extern const uint64_t aot_entry;
+extern uint64_t aot_dispatch(const uint64_t pc);
+
+// Provided by the runtime: run the instruction at pc in the interpreter
+// and return the next PC.
+extern uint64_t aot_interpret(const uint64_t pc);
+
+extern __thread machine_t guest;
+
+#endif
@@ -0,0 +1,53 @@
+/**************************************************************************
+ * C S 429 architecture emulator
+ *
+ * aot_rt.c - Runtime for guests translated ahead of time by aeaot.
+ *
+ * Loads the guest image embedded in the emitted C into emulated memory,
+ * sets up registers as runElf does, and then repeatedly calls
+ * aot_dispatch until the guest returns from main. Anything the
+ * translation does not cover (code it did not discover, HLT) runs in the
+ * interpreter.
+ *
+ * Copyright (c) 2022. S. Chatterjee. All rights reserved.
+ * May not be used, modified, or copied without permission.
+ **************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "archsim.h"
+#include "aot.h"
+
+uint64_t aot_interpret(const uint64_t pc) {
+    instr_t insn;
+    memset(&insn, 0, sizeof(insn));
+    guest.proc->regs[R_PC].xval = pc;
+    fetch_instr(&insn);
+    decode_instr(&insn);
+    execute_instr(&insn);
+    memory_instr(&insn);
+    wback_instr(&insn);
+    update_pc_instr(&insn);
+    return guest.proc->regs[R_PC].xval;
+}
+
+int main(int argc, char *argv[]) {
+    infile = stdin;
+    outfile = stdout;
+    errfile = stderr;
+    init_machine("AArch64", 64, L_ENDIAN, L_ENDIAN);
+    init_itable();
+    for (unsigned i = 0; i < aot_num_segs; i++)
+        for (uint64_t j = 0; j < aot_segs[i].size; j++)
+            mem_write_B(aot_segs[i].vaddr + j, aot_segs[i].data[j]);
+
+    guest.proc->regs[R_SP].xval = guest.mem->seg_start_addr[KERNEL_SEG]-8;
+    guest.proc->regs[R_NZCV].ccval = PACK_CC(0, 1, 0, 0);
+    guest.proc->regs[30].xval = RET_FROM_MAIN_ADDR;
+    uint64_t pc = aot_entry;
+    while (RET_FROM_MAIN_ADDR != pc)
+        pc = aot_dispatch(pc);
+    guest.proc->regs[R_PC].xval = pc;
+    return EXIT_SUCCESS;
+}